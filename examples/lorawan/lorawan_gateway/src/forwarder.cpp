@@ -79,7 +79,7 @@ void forwarderPing() {
 
 }
 
-void forwarderMessage(allwize_message_t message) {
+void forwarderMessage(const allwize_view_t & message) {
 
     // Update RX counters
     _forwarder_stats.rxnb = _forwarder_stats.rxnb + 1;
@@ -101,7 +101,7 @@ void forwarderMessage(allwize_message_t message) {
     snprintf_P(
         buffer, sizeof(buffer), 
         PSTR("{\"rxpk\":[{\"tmst\":%lu,\"time\":\"%s.00000Z\",\"chan\":%d,\"rfch\":%d,\"freq\":%.5f,\"stat\":%d,\"modu\":\"FSK\",\"datr\":%d,\"codr\":\"wize\",\"rssi\":%d,\"lsnr\":0.0,\"size\":%d,\"data\":\"%s\"}]}"),
-        now(), timestamp.c_str(), 
+        (unsigned long) message.last_byte_us, timestamp.c_str(), 
         WIZE_CHANNEL, 0, wizeFrequency(WIZE_CHANNEL), 1,
         wizeDataRateSpeed(WIZE_DATARATE),
         (int16_t) message.rssi / -2, message.len, data.c_str()
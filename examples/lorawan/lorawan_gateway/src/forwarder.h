@@ -9,5 +9,5 @@ FORWARDER MODULE
 #include "AllWize.h"
 
 void forwarderPing();
-void forwarderMessage(allwize_message_t message);
+void forwarderMessage(const allwize_view_t & message);
 void forwarderSetup();
\ No newline at end of file
@@ -33,6 +33,7 @@ void wizeSetup() {
     allwize.master();
     allwize.setChannel(WIZE_CHANNEL, true);
     allwize.setDataRate(WIZE_DATARATE);
+    allwize.setContinuousRX(true);
 
     #if defined(DEBUG_PORT)
     //allwize.dump(DEBUG_PORT);
@@ -42,7 +43,7 @@ void wizeSetup() {
 
 }
 
-void wizeDebugMessage(allwize_message_t message) {
+void wizeDebugMessage(const allwize_view_t & message) {
 
     // Code to pretty-print the message
     DEBUG_MSG(
@@ -65,16 +66,17 @@ void wizeDebugMessage(allwize_message_t message) {
 
 void wizeLoop() {
 
-    if (allwize.available()) {
+    // Get all the messages received since last loop
+    allwize_view_t messages[RX_QUEUE_SIZE];
+    size_t count = allwize.readMany(messages, RX_QUEUE_SIZE);
 
-        // Get the message
-        allwize_message_t message = allwize.read();
+    for (size_t i=0; i<count; i++) {
 
         // Show it to console
-        wizeDebugMessage(message);
+        wizeDebugMessage(messages[i]);
 
         // Forward it
-        forwarderMessage(message);
+        forwarderMessage(messages[i]);
 
     }
 
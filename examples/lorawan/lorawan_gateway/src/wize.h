@@ -9,7 +9,7 @@ WIZE MODULE
 #include "AllWize.h"
 
 void wizeSetup();
-void wizeDebugMessage(allwize_message_t message);
+void wizeDebugMessage(const allwize_view_t & message);
 double wizeFrequency(uint8_t channel);
 uint16_t wizeDataRateSpeed(uint8_t dr);
 void wizeLoop();
\ No newline at end of file
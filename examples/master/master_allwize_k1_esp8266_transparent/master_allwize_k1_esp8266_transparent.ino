@@ -121,6 +121,9 @@ void wizeLoop() {
         }
         DEBUG_SERIAL.println();
 
+        // Remove the decoded message from the queue
+        allwize.read();
+
     }
 
 }
@@ -68,6 +68,8 @@ WiFiEventHandler wifiDisconnectHandler;
 Ticker wifiTimer;
 
 AllWize allwize(RX_PIN, TX_PIN, RESET_PIN);
+char gateway_mid[5];
+char gateway_uid[9];
 
 // -----------------------------------------------------------------------------
 // Utils
@@ -139,6 +141,10 @@ void wizeSetup() {
     allwize.setPower(WIZE_POWER);
     allwize.setDataRate(WIZE_DATARATE);
 
+    // Gateway identity does not change, read it once
+    allwize.getMID(gateway_mid, sizeof(gateway_mid));
+    allwize.getUID(gateway_uid, sizeof(gateway_uid));
+
     DEBUG_SERIAL.printf("[WIZE] Module type: %s\n", allwize.getModuleTypeName().c_str());
     DEBUG_SERIAL.printf("[WIZE] MBUS mode: 0x%2X\n", allwize.getMode());
     DEBUG_SERIAL.printf("[WIZE] Channel: %d\n", allwize.getChannel());
@@ -164,12 +170,12 @@ void ping() {
     DynamicJsonDocument root(512);
     
     JsonObject gateway = root.createNestedObject("gateway");
-    gateway["mid"] = allwize.getMID();
-    gateway["uid"] = allwize.getUID();
+    gateway["mid"] = gateway_mid;
+    gateway["uid"] = gateway_uid;
     //gateway["sn"] = allwize.getSerialNumber();
 
     char topic[32];
-    snprintf(topic, sizeof(topic), "gateway/%s%s/ping", allwize.getMID().c_str(), allwize.getUID().c_str());
+    snprintf(topic, sizeof(topic), "gateway/%s%s/ping", gateway_mid, gateway_uid);
     String payload;
     serializeJson(root, payload);
     mqttSend(topic, payload.c_str());
@@ -192,8 +198,8 @@ void wizeMQTTParse(allwize_message_t message) {
     metadata["toa"] = 8000.0 * message.len / allwize.getDataRateSpeed(allwize.getDataRate());
     
     JsonObject gateway = root.createNestedObject("gateway");
-    gateway["mid"] = allwize.getMID();
-    gateway["uid"] = allwize.getUID();
+    gateway["mid"] = gateway_mid;
+    gateway["uid"] = gateway_uid;
     //gateway["sn"] = allwize.getSerialNumber();
     gateway["rssi"] = message.rssi / -2;
 
@@ -285,7 +291,7 @@ void wizeMQTTParse(allwize_message_t message) {
 
     #endif // DECODE_PAYLOAD
 
-    snprintf(topic, sizeof(topic), "gateway/%s%s/uplink", allwize.getMID().c_str(), allwize.getUID().c_str());
+    snprintf(topic, sizeof(topic), "gateway/%s%s/uplink", gateway_mid, gateway_uid);
     String output;
     serializeJson(root, output);
     mqttSend(topic, output.c_str());
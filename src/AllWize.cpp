@@ -91,17 +91,16 @@ void AllWize::_init() {
 void AllWize::begin(uint8_t baudrate) {
     
     _baudrate = BAUDRATES[baudrate-1];
+    _upgradeBaudRate(true);
     reset();
-    _niceDelay(200);
     
     // Figure out module type
     _readModel();
-    String part_number = getPartNumber();
-    if (part_number.equals("RC1701HP-MBUS4")) {
+    if (strcmp(_model, "RC1701HP-MBUS4") == 0) {
         _module = MODULE_MBUS4;
-    } else if (part_number.equals("RC1701HP-OSP")) {
+    } else if (strcmp(_model, "RC1701HP-OSP") == 0) {
         _module = MODULE_OSP;
-    } else if (part_number.equals("RC1701HP-WIZE")) {
+    } else if (strcmp(_model, "RC1701HP-WIZE") == 0) {
         _module = MODULE_WIZE;
         _ci = CI_WIZE;
     } else {
@@ -111,9 +110,93 @@ void AllWize::begin(uint8_t baudrate) {
     _append_rssi = _getSlot(MEM_RSSI_MODE) == 0x01;
     _mbus_mode = _getSlot(MEM_MBUS_MODE);
     _data_interface = _getSlot(MEM_DATA_INTERFACE);
+    _upgradeBaudRate(false);
     
 }
 
+/**
+ * @brief               Inits the module communications trusting a fingerprint saved by the
+ *                      application after a previous begin. The module is not reset and its model
+ *                      is not read, only the slots that define the frame layout and the baud rate
+ *                      are read back and checked against the fingerprint.
+ *                      Falls back to a regular begin if the fingerprint is not valid.
+ * @param fingerprint   Fingerprint as returned by getFingerprint
+ * @param baudrate      Baudrate used if the fingerprint is not valid (the fingerprint stores the one in use)
+ * @return              True if the fingerprint has been used
+ */
+bool AllWize::begin(const allwize_fingerprint_t & fingerprint, uint8_t baudrate) {
+    bool valid = _warmStart(fingerprint);
+    if (!valid) {
+        _module = MODULE_UNKNOWN;
+        begin(baudrate);
+    }
+    return valid;
+}
+
+/**
+ * @brief               Checks the fingerprint and the module slots it depends on,
+ *                      and sets the library state from it
+ * @param fingerprint   Fingerprint as returned by getFingerprint
+ * @return              True if the fingerprint is valid and matches the module
+ * @protected
+ */
+bool AllWize::_warmStart(const allwize_fingerprint_t & fingerprint) {
+
+    // Check fingerprint integrity
+    bool valid = 
+        (fingerprint.checksum == _crc16((uint8_t *) &fingerprint, sizeof(fingerprint) - sizeof(fingerprint.checksum))) &&
+        (MODULE_UNKNOWN != fingerprint.module) && (fingerprint.module < MODULE_MAX) &&
+        (0 < fingerprint.baudrate) && (fingerprint.baudrate <= BAUDRATE_COUNT);
+
+    if (valid) {
+
+        // The module keeps the baud rate it was running at, which may have been upgraded
+        _baudrate = BAUDRATES[fingerprint.baudrate-1];
+        _resetSerial();
+
+        _module = fingerprint.module;
+        if (MODULE_WIZE == _module) _ci = CI_WIZE;
+        _mbus_mode = fingerprint.mbus_mode;
+        _data_interface = fingerprint.data_interface;
+        _append_rssi = (fingerprint.append_rssi == 1);
+
+        // Cheap check that the module is there and has not been reconfigured,
+        // all the slots are read in the same config session
+        const uint8_t slots[] = { MEM_MBUS_MODE, MEM_RSSI_MODE, MEM_DATA_INTERFACE, MEM_UART_BAUD_RATE };
+        const uint8_t expected[] = { _mbus_mode, fingerprint.append_rssi, _data_interface, fingerprint.baudrate };
+        valid = beginConfig();
+        for (uint8_t i = 0; valid && (i < sizeof(slots)); i++) {
+            uint8_t address = _getAddress(slots[i]);
+            if (0xFF == address) continue;
+            uint8_t value = 0xFF;
+            valid = (_readMemory(address, &value, 1) == 1) && (value == expected[i]);
+        }
+        if (!commitConfig()) valid = false;
+
+    }
+
+    return valid;
+
+}
+
+/**
+ * @brief               Returns a fingerprint of the current module configuration
+ *                      the application can store and use on the next begin
+ * @param fingerprint   Fingerprint to fill
+ * @return              True if the module is known and the fingerprint is valid
+ */
+bool AllWize::getFingerprint(allwize_fingerprint_t & fingerprint) {
+    if (MODULE_UNKNOWN == _module) return false;
+    memset(&fingerprint, 0, sizeof(fingerprint));
+    fingerprint.module = _module;
+    fingerprint.mbus_mode = _mbus_mode;
+    fingerprint.data_interface = _data_interface;
+    fingerprint.append_rssi = _append_rssi ? 1 : 0;
+    fingerprint.baudrate = _getBaudRateCode();
+    fingerprint.checksum = _crc16((uint8_t *) &fingerprint, sizeof(fingerprint) - sizeof(fingerprint.checksum));
+    return true;
+}
+
 /**
  * @brief               Resets the serial object
  */
@@ -148,53 +231,37 @@ void AllWize::_resetSerial() {
 
     _flush();
 
-    // Cache memory
-    #if USE_MEMORY_CACHE
-        _ready = _cacheMemory(_memory);
+    // Invalidate memory cache, pages will be read when needed
+    #if USE_MEMORY_CACHE == MEMORY_CACHE_FULL
+        _memory_valid = 0;
+        memset(_memory_dirty, 0, sizeof(_memory_dirty));
+    #elif USE_MEMORY_CACHE == MEMORY_CACHE_SLOTS
+        _slot_valid = 0;
     #endif
 
 }
 
 /**
- * @brief               Resets the radio module.
- * @return              Reset successfully issued
+ * @brief               Resets the radio module and waits for it to be ready.
+ *                      The time it took is available via getResetTime.
+ * @return              True if the module is ready after the reset
  */
 bool AllWize::reset() {
-    if (GPIO_NONE == _reset_gpio) {
-        _resetSerial();
-        _niceDelay(100);
-        _setSlot(MEM_CONFIG_INTERFACE, 1);
-        if (_setConfig(true)) {
-            _send('@');
-            _send('R');
-            _send('R');
-            _niceDelay(100);
-            if (GPIO_NONE != _config_gpio) {
-                digitalWrite(_config_gpio, LOW);
-            }
-            _config = false;
-            _resetSerial();
-            return true;
-        }
-    } else {
-        digitalWrite(_reset_gpio, LOW);
-        _niceDelay(1);
-        digitalWrite(_reset_gpio, HIGH);
-        _niceDelay(100);
-        if (GPIO_NONE != _config_gpio) {
-            digitalWrite(_config_gpio, LOW);
-        }
-        _config = false;
+    uint32_t start = millis();
+    bool response = false;
+    if (_resetModule()) {
         _resetSerial();
-        return true;
+        response = _waitForReset(RESET_TIMEOUT);
     }
-    return false;
+    _reset_time = millis() - start;
+    return response;
 }
 
 /**
  * @brief               Cleans the RX/TX line
  */
 void AllWize::softReset() {
+    _rx_reset_pending = false;
     if (_setConfig(true)) _setConfig(false);
     /*
     if (_send(CMD_ENTER_CONFIG) == 1) {
@@ -206,26 +273,29 @@ void AllWize::softReset() {
 }
 
 /**
- * @brief               Resets the module to factory settings
- * @return              Factory reset successfully issued
+ * @brief               Resets the module to factory settings and waits for it to be ready.
+ *                      The time it took is available via getResetTime.
+ * @return              True if the module is ready after the reset
  */
 bool AllWize::factoryReset() {
+    uint32_t start = millis();
+    bool response = false;
     _resetSerial();
-    _niceDelay(100);
-    _setSlot(MEM_CONFIG_INTERFACE, 1);
-    if (_setConfig(true)) {
-        _send('@');
-        _send('R');
-        _send('C');
-        _niceDelay(100);
-        if (GPIO_NONE != _config_gpio) {
-            digitalWrite(_config_gpio, LOW);
-        }
-        _config = false;
+    waitForReady(RESET_TIMEOUT);
+    if (_sendReset('C')) {
         _resetSerial();
-        return true;
+        response = _waitForReset(RESET_TIMEOUT);
     }
-    return false;
+    _reset_time = millis() - start;
+    return response;
+}
+
+/**
+ * @brief               Returns the time the last reset took until the module was ready
+ * @return              Milliseconds
+ */
+uint32_t AllWize::getResetTime() {
+    return _reset_time;
 }
 
 /**
@@ -262,6 +332,90 @@ void AllWize::repeater() {
     setNetworkRole(NETWORK_ROLE_REPEATER);
 }
 
+/**
+ * @brief               Applies a configuration profile, only the settings that differ from
+ *                      the ones stored in the module are written, in a single config session
+ * @param profile       Profile to apply
+ * @return              PROFILE_* flags for the settings that have changed,
+ *                      PROFILE_ERROR is set if any of them could not be written, or alone if
+ *                      any of them is not accepted by the module (nothing is written then)
+ */
+uint16_t AllWize::applyProfile(const allwize_profile_t & profile) {
+
+    uint16_t changed = 0;
+    if (!beginConfig()) return PROFILE_ERROR;
+
+    // Read all the current values before staging any write,
+    // so the writes all go out in the single flush at commit
+    uint8_t network_role = (PROFILE_KEEP != profile.network_role) ? getNetworkRole() : PROFILE_KEEP;
+    uint8_t channel = (PROFILE_KEEP != profile.channel) ? getChannel() : PROFILE_KEEP;
+    uint8_t power = (PROFILE_KEEP != profile.power) ? getPower() : PROFILE_KEEP;
+    uint8_t data_rate = (PROFILE_KEEP != profile.data_rate) ? getDataRate() : PROFILE_KEEP;
+    uint8_t mbus_mode = (PROFILE_KEEP != profile.mbus_mode) ? _getSlot(MEM_MBUS_MODE) : PROFILE_KEEP;
+    uint8_t data_interface = (PROFILE_KEEP != profile.data_interface) ? _getSlot(MEM_DATA_INTERFACE) : PROFILE_KEEP;
+    uint8_t append_rssi = (PROFILE_KEEP != profile.append_rssi) ? _getSlot(MEM_RSSI_MODE) : PROFILE_KEEP;
+    uint8_t key[16];
+    if (NULL != profile.default_key) getDefaultKey(key);
+
+    // Values the setters would reject are errors, the rest are compared
+    // with the memory contents the way the setters store them
+    uint8_t data_rate_value = (PROFILE_KEEP != profile.data_rate) ? _dataRateValue(profile.data_rate) : PROFILE_KEEP;
+    if ((PROFILE_KEEP != profile.channel) && (profile.channel > 41)) changed |= PROFILE_ERROR;
+    if ((PROFILE_KEEP != profile.power) && ((profile.power < 1) || (profile.power > 5))) changed |= PROFILE_ERROR;
+    if ((PROFILE_KEEP != profile.data_rate) && (0xFF == data_rate_value)) changed |= PROFILE_ERROR;
+    if ((PROFILE_KEEP != profile.mbus_mode) && !_modeAllowed(profile.mbus_mode)) changed |= PROFILE_ERROR;
+    if ((PROFILE_KEEP != profile.data_interface) && (profile.data_interface > 0x0C)) changed |= PROFILE_ERROR;
+    if ((PROFILE_KEEP != profile.append_rssi) && (profile.append_rssi > 1)) changed |= PROFILE_ERROR;
+    if (changed) {
+        commitConfig();
+        return changed;
+    }
+
+    if (network_role != profile.network_role) {
+        setNetworkRole(profile.network_role);
+        changed |= PROFILE_NETWORK_ROLE;
+    }
+
+    if (channel != profile.channel) {
+        setChannel(profile.channel, true);
+        changed |= PROFILE_CHANNEL;
+    }
+
+    if (power != profile.power) {
+        setPower(profile.power, true);
+        changed |= PROFILE_POWER;
+    }
+
+    if (data_rate != data_rate_value) {
+        setDataRate(profile.data_rate);
+        changed |= PROFILE_DATA_RATE;
+    }
+
+    if (mbus_mode != profile.mbus_mode) {
+        setMode(profile.mbus_mode, true);
+        changed |= PROFILE_MBUS_MODE;
+    }
+
+    if (data_interface != profile.data_interface) {
+        setDataInterface(profile.data_interface);
+        changed |= PROFILE_DATA_INTERFACE;
+    }
+
+    if (append_rssi != profile.append_rssi) {
+        setAppendRSSI(profile.append_rssi == 1);
+        changed |= PROFILE_APPEND_RSSI;
+    }
+
+    if ((NULL != profile.default_key) && (memcmp(key, profile.default_key, 16) != 0)) {
+        setDefaultKey(profile.default_key);
+        changed |= PROFILE_DEFAULT_KEY;
+    }
+
+    if (!commitConfig()) changed |= PROFILE_ERROR;
+    return changed;
+
+}
+
 /**
  * @brief               Sets the radio module in sleep mode
  */
@@ -290,14 +444,99 @@ bool AllWize::ready() {
 
 /**
  * @brief               Waits for timeout millis for the module to be ready
+ *                      probing it with a short timeout every RESET_PROBE_INTERVAL millis
  */
 bool AllWize::waitForReady(uint32_t timeout) {
     uint32_t start = millis();
+    uint32_t saved = _timeout;
+    bool response = false;
+    _timeout = RESET_PROBE_TIMEOUT;
     while (millis() - start < timeout) {
-        if (ready()) return true;
-        _niceDelay(100);
+        if (ready()) {
+            response = true;
+            break;
+        }
+        _niceDelay(RESET_PROBE_INTERVAL);
     }
-    return false;
+    _timeout = saved;
+    return response;
+}
+
+/**
+ * @brief               Starts a configuration transaction, the module stays in config mode
+ *                      for all the following setters until commitConfig is called.
+ *                      Transactions can be nested, only the outermost one exits config mode.
+ * @return              True if the module is in config mode
+ */
+bool AllWize::beginConfig() {
+    if (0 == _config_depth) _config_errors = 0;
+    if (!_setConfig(true)) {
+        _config_errors++;
+        return false;
+    }
+    _config_depth++;
+    return true;
+}
+
+/**
+ * @brief               Ends a configuration transaction, if it is the outermost one
+ *                      pending memory changes are written and config mode is exited
+ * @return              True if all the commands in the transaction succeeded
+ */
+bool AllWize::commitConfig() {
+    if (0 == _config_depth) return false;
+    if (0 == --_config_depth) {
+        flushMemory();
+        _setConfig(false);
+    }
+    return (0 == _config_errors);
+}
+
+/**
+ * @brief               Writes all pending memory changes to the module non-volatile memory
+ *                      using a single write memory command
+ * @return              True if there were no pending changes or they were successfully saved
+ */
+bool AllWize::flushMemory() {
+
+    #if USE_MEMORY_CACHE == MEMORY_CACHE_FULL
+
+        // Anything to write?
+        bool dirty = false;
+        for (uint8_t i = 0; i < sizeof(_memory_dirty); i++) {
+            if (_memory_dirty[i]) {
+                dirty = true;
+                break;
+            }
+        }
+        if (!dirty) return true;
+
+        // Address 0xFF cannot be written since it is the end of command marker
+        int8_t response = -1;
+        if (_setConfig(true)) {
+            if (_sendAndReceive(CMD_WRITE_MEMORY) != -1) {
+                for (uint8_t address = 0; address < 0xFF; address++) {
+                    if (_memory_dirty[address >> 3] & (1 << (address & 0x07))) {
+                        _send(address);
+                        _send(_memory[address]);
+                    }
+                }
+                response = _sendAndReceive(CMD_EXIT_MEMORY);
+            }
+            _setConfig(false);
+        }
+
+        // Keep changes pending if failed
+        if (-1 == response) {
+            _config_errors++;
+            return false;
+        }
+        memset(_memory_dirty, 0, sizeof(_memory_dirty));
+
+    #endif
+
+    return true;
+
 }
 
 /**
@@ -306,16 +545,20 @@ bool AllWize::waitForReady(uint32_t timeout) {
  */
 void AllWize::dump(Stream &debug) {
 
-    #if not USE_MEMORY_CACHE
-        uint8_t _memory[0x100] = {0xFF};
-        bool _ready = _cacheMemory(_memory);
+    #if USE_MEMORY_CACHE == MEMORY_CACHE_FULL
+        if (!_fetchMemory(0, 0x100)) {
+            debug.println("Error doing memory dump...");
+            return;
+        }
+    #else
+        // Read a page at a time instead of holding the whole memory on the stack
+        uint8_t page[MEMORY_PAGE_SIZE];
+        if (!beginConfig()) {
+            debug.println("Error doing memory dump...");
+            return;
+        }
     #endif
 
-    if (!_ready) {
-        debug.println("Error doing memory dump...");
-        return;
-    }
-
     char ch[10];
     char ascii[17] = {0};
     uint8_t address = 0;
@@ -336,15 +579,28 @@ void AllWize::dump(Stream &debug) {
         if ((address % 16) == 0) {
             if (address > 0)
                 debug.print(ascii);
+            #if USE_MEMORY_CACHE != MEMORY_CACHE_FULL
+                if (_readMemory(address, page, MEMORY_PAGE_SIZE) != MEMORY_PAGE_SIZE) {
+                    commitConfig();
+                    debug.println();
+                    debug.println("Error doing memory dump...");
+                    return;
+                }
+            #endif
             snprintf(ch, sizeof(ch), "\n0x%02X:  ", address);
             debug.print(ch);
         }
-        if ((31 < _memory[address]) && (_memory[address] < 127)) {
-            ascii[address % 16] = (char)_memory[address];
+        #if USE_MEMORY_CACHE == MEMORY_CACHE_FULL
+            uint8_t value = _memory[address];
+        #else
+            uint8_t value = page[address % MEMORY_PAGE_SIZE];
+        #endif
+        if ((31 < value) && (value < 127)) {
+            ascii[address % 16] = (char) value;
         } else {
             ascii[address % 16] = ' ';
         }
-        snprintf(ch, sizeof(ch), "%02X ", (uint8_t)_memory[address]);
+        snprintf(ch, sizeof(ch), "%02X ", value);
         debug.print(ch);
         
         if (0xFF == address) break;
@@ -352,6 +608,10 @@ void AllWize::dump(Stream &debug) {
 
     }
 
+    #if USE_MEMORY_CACHE != MEMORY_CACHE_FULL
+        commitConfig();
+    #endif
+
     debug.println();
     debug.println();
 
@@ -451,192 +711,483 @@ bool AllWize::enableRX(bool enable) {
 }
 
 /**
- * @brief               Returns true if a new message has been received and decoded
+ * @brief               Returns true if there are received messages pending to be read
  *                      This method has to be called in the main loop to monitor for incoming messages
  * @return              Whether a new message is available
  */
 bool AllWize::available() {
+    _pump();
+    return (_queue_count > 0);
+}
 
-    bool response = false;
+/**
+ * @brief               Reads the stream and decodes any complete frame, messages are passed to the
+ *                      onMessage callback if any, otherwise they are stored in the receive queue.
+ *                      Call it from the main loop instead of available() when using onMessage,
+ *                      or from an RTOS task that owns the module (no other method can run at the
+ *                      same time). It is not safe to call from an interrupt: it soft resets the
+ *                      line after every frame unless in continuous RX mode, and that waits for the module.
+ * @return              Number of new messages received
+ */
+uint8_t AllWize::pump() {
+    return _pump();
+}
 
-    static uint32_t when = millis();
+/**
+ * @brief               Sets a callback to be called for every new message received
+ *                      The message data is only valid until the callback returns
+ * @param callback      Function to call, NULL to go back to the receive queue
+ * @param ctx           User pointer passed to the callback
+ */
+void AllWize::onMessage(allwize_callback_t callback, void * ctx) {
+    _callback = callback;
+    _callback_ctx = ctx;
+}
 
-    while (_stream->available() && _pointer < RX_BUFFER_SIZE) {
+/**
+ * @brief               Sends a command to the module without waiting for the response
+ *                      The command progresses every time poll() is called and the callback is
+ *                      called once it has finished. Blocking methods wait for it to finish first.
+ * @param command       Command key (CMD_*)
+ * @param data          Binary data to send, it is copied
+ * @param len           Length of the binary data (up to COMMAND_ASYNC_SIZE)
+ * @param callback      Function to call when done
+ * @param ctx           User pointer passed to the callback
+ * @return              True if the command has been started, false if busy or too long
+ */
+bool AllWize::commandAsync(uint8_t command, const uint8_t * data, uint8_t len, allwize_command_callback_t callback, void * ctx) {
+    if (COMMAND_STATE_IDLE != _cmd_state) return false;
+    if (len > COMMAND_ASYNC_SIZE) return false;
+    if (len > 0) memcpy(_cmd_copy, data, len);
+    return _commandStart(command, _cmd_copy, len, callback, ctx);
+}
 
-        uint8_t ch = _stream->read();
+/**
+ * @brief               Progresses the command in flight, if any, should be called from the main loop
+ * @return              True if there is a command in flight
+ */
+bool AllWize::poll() {
 
-        #if defined(ALLWIZE_DEBUG_PORT)
-        {
-            char buffer[10];
-            snprintf(buffer, sizeof(buffer), "r %02X '%c'", ch, (32 <= ch && ch <= 126) ? ch : 32);
-            ALLWIZE_DEBUG_PRINTLN(buffer);
+    // Responses are collected into the response buffer until the prompt, the receive buffer may hold a frame
+    while ((COMMAND_STATE_ENTER <= _cmd_state) && (_cmd_state <= COMMAND_STATE_RESPONSE) && _stream->available()) {
+        
+        uint8_t ch = _stream->read();
+        _cmd_last = millis();
+        if (END_OF_RESPONSE != ch) {
+            if (_cmd_count < COMMAND_RESPONSE_SIZE) _response[_cmd_count++] = ch;
+            continue;
         }
-        #endif
 
-        _buffer[_pointer++] = ch;
-        when = millis();
+        if (COMMAND_STATE_ENTER == _cmd_state) {
+            
+            // Module must answer the enter config command just with the prompt
+            if (0 != _cmd_count) {
+                _commandDone();
+                break;
+            }
+            _config = true;
+            _send(_cmd_command);
+            _cmd_count = 0;
+            _cmd_state = (_cmd_len > 0) ? COMMAND_STATE_PROMPT : COMMAND_STATE_RESPONSE;
 
-        #if defined(ARDUINO_ARCH_ESP8266)
-            yield();
-        #endif
+        } else if (COMMAND_STATE_PROMPT == _cmd_state) {
+            
+            _send((uint8_t *) _cmd_data, _cmd_len);
+            _cmd_count = 0;
+            _cmd_state = COMMAND_STATE_RESPONSE;
+
+        } else {
+            
+            _cmd_result = _cmd_count;
+            _commandExit();
+
+        }
 
     }
 
-    // Check if message finished and decode it
-    if ((_pointer > 0) && (millis() - when > 100)) {
-        
-        response = _decode();
-        _length = _pointer;
-        _pointer = 0;
-        
-        // If we don't soft-reset the line the RX channel gets stalled
-        softReset();
+    switch (_cmd_state) {
+
+        case COMMAND_STATE_ENTER:
+            if (millis() - _cmd_last > _timeout) _commandDone();
+            break;
+
+        case COMMAND_STATE_PROMPT:
+        case COMMAND_STATE_RESPONSE:
+            if (millis() - _cmd_last > _timeout) _commandExit();
+            break;
+
+        case COMMAND_STATE_EXIT:
+            if (millis() - _cmd_last >= 5) _commandDone();
+            break;
+
+        default:
+            break;
 
     }
 
-    return response;
+    return (COMMAND_STATE_IDLE != _cmd_state);
 
 }
 
 /**
- * @brief               Returns latest received message
- * @return              New message
+ * @brief               Enables or disables continuous RX mode
+ *                      By default the line is soft-reset after every received frame to avoid the RX channel
+ *                      getting stalled, but that means entering and leaving config mode, during which any
+ *                      incoming frame is lost. In continuous RX mode the line is only soft-reset after a
+ *                      broken frame or if nothing has been received in the last stall_timeout milliseconds.
+ * @param enable        True to enable continuous RX mode
+ * @param stall_timeout Milliseconds without data before kicking the RX channel (0 to disable)
  */
-allwize_message_t AllWize::read() {
-    return _message;
+void AllWize::setContinuousRX(bool enable, uint32_t stall_timeout) {
+    _continuous_rx = enable;
+    _rx_stall_timeout = stall_timeout;
+    _rx_last = millis();
 }
 
 /**
- * @brief               Returns pointer to the last message raw data buffer
- *                      Should be copied right away since any new incomming message with overwrite it
- * @return              Message buffer
+ * @brief               Returns whether continuous RX mode is enabled
+ * @return              True if continuous RX mode is enabled
  */
-uint8_t * AllWize::getBuffer() {
-    return _buffer;
+bool AllWize::getContinuousRX() {
+    return _continuous_rx;
 }
 
 /**
- * @brief               Returns the length of the last message raw data buffer
- * @return              Message length
+ * @brief               Returns the oldest received message and removes it from the queue
+ * @return              New message
  */
-uint8_t AllWize::getLength() {
-    return _length;
+allwize_message_t AllWize::read() {
+    return *_queuePop();
 }
 
 /**
- * @brief               Sets the wize control field in the transport layer
- * @param wize_control  Wize Control (defined the key to be used)
- * @return              True is correctly set
+ * @brief               Returns the oldest received message without copying its payload and removes it from the queue
+ *                      The view data points to the library receive storage and is only valid until the next call to available()
+ * @param view          View to fill with the message header and a pointer to its payload
+ * @return              True if there was a message to read
  */
-bool AllWize::setWizeControl(uint8_t wize_control) {
-    if (wize_control > 14) return false;
-    _wize_control = wize_control;
+bool AllWize::read(allwize_view_t & view) {
+    if (0 == _queue_count) return false;
+    _view(_queuePop(), view);
     return true;
 }
 
 /**
- * @brief                   Use AllWize::setWizeNetworkId instead
- * @deprecated
+ * @brief               Reads all the messages already received, up to max
+ *                      Every complete frame waiting in the stream is read, outside continuous RX mode
+ *                      the line is soft reset once the stream has been drained.
+ *                      When decoding in place (RX_DECODE_IN_PLACE) only one message is read per call.
+ * @param out           Array of at least max messages to copy the messages to
+ * @param max           Maximum number of messages to read
+ * @return              Number of messages read
  */
-void AllWize::setWizeOperatorId(uint8_t wize_network_id) { 
-    setWizeNetworkId(wize_network_id);
+size_t AllWize::readMany(allwize_message_t * out, size_t max) {
+    size_t count = 0;
+    #if RX_DECODE_IN_PLACE
+        // Every message payload points to the same receive buffer
+        if (max > 1) max = 1;
+    #endif
+    while (count < max) {
+        if (0 == _queue_count) {
+            _pump(true);
+            if (0 == _queue_count) break;
+        }
+        out[count++] = *_queuePop();
+    }
+    return count;
 }
 
 /**
- * @brief                   Sets the wize network ID field in the transpoprt layer
- * @param wize_network_id   Wize Network ID
+ * @brief               Reads all the messages already received, up to max and up to RX_QUEUE_SIZE, without copying their payloads
+ *                      The views data point to the library receive storage and are only valid until the next call to available()
+ * @param out           Array of at least max views to fill
+ * @param max           Maximum number of messages to read
+ * @return              Number of messages read
  */
-void AllWize::setWizeNetworkId(uint8_t wize_network_id) {
-    _wize_network_id = wize_network_id;
+size_t AllWize::readMany(allwize_view_t * out, size_t max) {
+    size_t count = 0;
+    _pump(true);
+    while ((count < max) && (_queue_count > 0)) {
+        _view(_queuePop(), out[count++]);
+    }
+    return count;
 }
 
 /**
- * @brief                   Sets the wize applicaton field in the transpoprt layer
- * @param wize_application  Wize Application
+ * @brief               Returns the number of messages received with a wrong CRC
+ *                      Only checked if the data interface includes the CRC (DATA_INTERFACE_CRC*)
+ * @return              Number of messages with a wrong CRC
  */
-void AllWize::setWizeApplication(uint8_t wize_application) {
-    _wize_application = wize_application;
+uint32_t AllWize::getCRCErrors() {
+    return _crc_errors;
 }
 
 /**
- * @brief               Sets the wize couonter field in the transpoprt layer
- * @param counter       Wize counter
+ * @brief               Returns the number of frames dropped because they do not fit in the
+ *                      receive buffer (RX_BUFFER_SIZE)
+ * @return              Number of frames too long for the receive buffer
  */
-void AllWize::setCounter(uint16_t counter) { 
-    _counter = counter; 
+uint32_t AllWize::getOversizedFrames() {
+    return _oversized_frames;
 }
 
 /**
- * @brief               Gets the current wize counter
- * @return              Counter
+ * @brief               Sets an allow-list of device addresses, messages from other devices
+ *                      are discarded before being queued. Messages without header are not filtered.
+ *                      The array is not copied and must be kept by the caller.
+ * @param addresses     Array of addresses sorted in ascending order, as printed (0x01020304 for
+ *                      address {0x01, 0x02, 0x03, 0x04}), NULL to disable
+ * @param count         Number of addresses in the array
  */
-uint16_t AllWize::getCounter() { 
-    return _counter; 
+void AllWize::setFilter(const uint32_t * addresses, uint16_t count) {
+    _filter_addresses = addresses;
+    _filter_count = (NULL == addresses) ? 0 : count;
 }
 
-// -----------------------------------------------------------------------------
-// Configuration
-// -----------------------------------------------------------------------------
+#if FILTER_BLOOM_BITS > 0
 
 /**
- * @brief               Sets the control information byte
- * @param  ci           CI byte value
+ * @brief               Adds an address to the Bloom filter, once an address has been added
+ *                      messages from devices not in the filter are discarded (with some false positives)
+ * @param address       Device address, as printed
  */
-void AllWize::setControlInformation(uint8_t ci) {
-    _ci = ci;
+void AllWize::addBloomFilter(uint32_t address) {
+    uint32_t h1 = address * 2654435761UL;
+    uint32_t h2 = (address ^ (address >> 16)) * 2246822519UL | 1;
+    for (uint8_t i = 0; i < FILTER_BLOOM_HASHES; i++) {
+        uint32_t bit = (h1 + i * h2) % FILTER_BLOOM_BITS;
+        _filter_bloom[bit >> 3] |= (1 << (bit & 0x07));
+    }
+    _filter_bloom_enabled = true;
 }
 
 /**
- * @brief               Gets the control information byte
- * @return              CI byte value
+ * @brief               Removes all addresses from the Bloom filter and disables it
  */
-uint8_t AllWize::getControlInformation() {
-    return _ci;
+void AllWize::clearBloomFilter() {
+    memset(_filter_bloom, 0, sizeof(_filter_bloom));
+    _filter_bloom_enabled = false;
 }
 
+#endif
+
 /**
- * @brief               Sets the communications channel (for MBUS_MODE_R2 only)
- * @param channel       Channel number
- * @param persist       Persist the changes in non-volatile memory (defaults to False)
+ * @brief               Returns the number of messages accepted by the device filter
+ * @return              Number of messages
  */
-void AllWize::setChannel(uint8_t channel, bool persist) {
-    if (channel > 41) return;
-    if (persist) {
-        _setSlot(MEM_CHANNEL, channel);
-        if (MODULE_WIZE == _module) {
-            _setSlot(MEM_CHANNEL_RX, channel);
-        }
-    }
-    _sendCommand(CMD_CHANNEL, channel);
+uint32_t AllWize::getFilterHits() {
+    return _filter_hits;
 }
 
 /**
- * @brief               Gets the channel stored in non-volatile memory
- * @return              Channel (1 byte)
+ * @brief               Returns the number of messages discarded by the device filter
+ * @return              Number of messages
  */
-uint8_t AllWize::getChannel() {
-    return _getSlot(MEM_CHANNEL);
+uint32_t AllWize::getFilterMisses() {
+    return _filter_misses;
 }
 
+#if DEDUP_CACHE_SIZE > 0
+
 /**
- * @brief               Sets the RF power
- * @param power         Value from 1 to 5
- * @param persist       Persist the changes in non-volatile memory (defaults to False)
+ * @brief               Sets the time window to consider a message a duplicate of a previous one
+ *                      with the same manufacturer, address and wize counter
+ * @param ms            Window in milliseconds (defaults to DEDUP_WINDOW)
  */
-void AllWize::setPower(uint8_t power, bool persist) {
-    if (0 < power && power < 6) {
-        if (persist) {
-            _setSlot(MEM_RF_POWER, power);
-        }
-        _sendCommand(CMD_RF_POWER, power);
-    }
+void AllWize::setDuplicateWindow(uint32_t ms) {
+    _dedup_window = ms;
 }
 
 /**
- * @brief               Gets the RF power stored in non-volatile memory
- * @return              RF power (1 byte)
+ * @brief               Returns the number of duplicate messages received
+ * @return              Number of duplicate messages
  */
-uint8_t AllWize::getPower() {
+uint32_t AllWize::getDuplicates() {
+    return _duplicates;
+}
+
+#endif
+
+#if RX_LATENCY_BUCKETS > 0
+
+/**
+ * @brief               Returns the number of messages read with a latency (time from the first byte
+ *                      received to the message being read) in the given bucket
+ *                      Bucket 0 is for latencies under 1ms, bucket N from 2^(N-1) to 2^N ms
+ * @param bucket        Bucket index, from 0 to RX_LATENCY_BUCKETS-1
+ * @return              Number of messages
+ */
+uint32_t AllWize::getLatencyHistogram(uint8_t bucket) {
+    if (bucket >= RX_LATENCY_BUCKETS) return 0;
+    return _latency[bucket];
+}
+
+/**
+ * @brief               Resets the latency histogram
+ */
+void AllWize::resetLatencyHistogram() {
+    memset(_latency, 0, sizeof(_latency));
+}
+
+#endif
+
+/**
+ * @brief               Sets what to do when a message arrives and the receive queue is full
+ * @param policy        RX_QUEUE_DROP_OLDEST (default) or RX_QUEUE_DROP_NEWEST
+ */
+void AllWize::setQueuePolicy(uint8_t policy) {
+    if (RX_QUEUE_DROP_OLDEST == policy || RX_QUEUE_DROP_NEWEST == policy) {
+        _queue_policy = policy;
+    }
+}
+
+/**
+ * @brief               Returns the number of received messages pending to be read
+ * @return              Number of messages in the receive queue
+ */
+uint8_t AllWize::getQueueCount() {
+    return _queue_count;
+}
+
+/**
+ * @brief               Returns the number of messages dropped because the receive queue was full
+ * @return              Number of dropped messages
+ */
+uint32_t AllWize::getQueueOverflows() {
+    return _queue_overflows;
+}
+
+/**
+ * @brief               Returns pointer to the last message raw data buffer
+ *                      Should be copied right away since any new incomming message with overwrite it
+ * @return              Message buffer
+ */
+uint8_t * AllWize::getBuffer() {
+    return _buffer;
+}
+
+/**
+ * @brief               Returns the length of the last message raw data buffer
+ * @return              Message length
+ */
+uint8_t AllWize::getLength() {
+    return _length;
+}
+
+/**
+ * @brief               Sets the wize control field in the transport layer
+ * @param wize_control  Wize Control (defined the key to be used)
+ * @return              True is correctly set
+ */
+bool AllWize::setWizeControl(uint8_t wize_control) {
+    if (wize_control > 14) return false;
+    _wize_control = wize_control;
+    return true;
+}
+
+/**
+ * @brief                   Use AllWize::setWizeNetworkId instead
+ * @deprecated
+ */
+void AllWize::setWizeOperatorId(uint8_t wize_network_id) { 
+    setWizeNetworkId(wize_network_id);
+}
+
+/**
+ * @brief                   Sets the wize network ID field in the transpoprt layer
+ * @param wize_network_id   Wize Network ID
+ */
+void AllWize::setWizeNetworkId(uint8_t wize_network_id) {
+    _wize_network_id = wize_network_id;
+}
+
+/**
+ * @brief                   Sets the wize applicaton field in the transpoprt layer
+ * @param wize_application  Wize Application
+ */
+void AllWize::setWizeApplication(uint8_t wize_application) {
+    _wize_application = wize_application;
+}
+
+/**
+ * @brief               Sets the wize couonter field in the transpoprt layer
+ * @param counter       Wize counter
+ */
+void AllWize::setCounter(uint16_t counter) { 
+    _counter = counter; 
+}
+
+/**
+ * @brief               Gets the current wize counter
+ * @return              Counter
+ */
+uint16_t AllWize::getCounter() { 
+    return _counter; 
+}
+
+// -----------------------------------------------------------------------------
+// Configuration
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief               Sets the control information byte
+ * @param  ci           CI byte value
+ */
+void AllWize::setControlInformation(uint8_t ci) {
+    _ci = ci;
+}
+
+/**
+ * @brief               Gets the control information byte
+ * @return              CI byte value
+ */
+uint8_t AllWize::getControlInformation() {
+    return _ci;
+}
+
+/**
+ * @brief               Sets the communications channel (for MBUS_MODE_R2 only)
+ * @param channel       Channel number
+ * @param persist       Persist the changes in non-volatile memory (defaults to False)
+ */
+void AllWize::setChannel(uint8_t channel, bool persist) {
+    if (channel > 41) return;
+    if (persist) {
+        _setSlot(MEM_CHANNEL, channel);
+        if (MODULE_WIZE == _module) {
+            _setSlot(MEM_CHANNEL_RX, channel);
+        }
+    }
+    _sendCommand(CMD_CHANNEL, channel);
+}
+
+/**
+ * @brief               Gets the channel stored in non-volatile memory
+ * @return              Channel (1 byte)
+ */
+uint8_t AllWize::getChannel() {
+    return _getSlot(MEM_CHANNEL);
+}
+
+/**
+ * @brief               Sets the RF power
+ * @param power         Value from 1 to 5
+ * @param persist       Persist the changes in non-volatile memory (defaults to False)
+ */
+void AllWize::setPower(uint8_t power, bool persist) {
+    if (0 < power && power < 6) {
+        if (persist) {
+            _setSlot(MEM_RF_POWER, power);
+        }
+        _sendCommand(CMD_RF_POWER, power);
+    }
+}
+
+/**
+ * @brief               Gets the RF power stored in non-volatile memory
+ * @return              RF power (1 byte)
+ */
+uint8_t AllWize::getPower() {
     return _getSlot(MEM_RF_POWER);
 }
 
@@ -646,22 +1197,36 @@ uint8_t AllWize::getPower() {
  */
 void AllWize::setDataRate(uint8_t dr) {
 
-    if (_module == MODULE_MBUS4) return;
-    if (dr < 1) return;
+    dr = _dataRateValue(dr);
+    if (0xFF == dr) return;
+
+    _setSlot(MEM_DATA_RATE, dr);
+    if (MODULE_WIZE == _module) {
+        _setSlot(MEM_DATA_RATE_RX, dr);
+    }
+
+}
+
+/**
+ * @brief               Maps a data rate to the value stored in the module memory
+ * @param dr            Value in [1, 2, 3, 4, 5]
+ * @return              Value to store, 0xFF if the module does not accept it
+ * @protected
+ */
+uint8_t AllWize::_dataRateValue(uint8_t dr) {
+
+    if (_module == MODULE_MBUS4) return 0xFF;
+    if (dr < 1) return 0xFF;
     if (_module == MODULE_OSP) {
         if (DATARATE_6400bps == dr) {
             dr = DATARATE_6400bps_OSP;
         }
-        if (dr > 5) return;
+        if (dr > 5) return 0xFF;
     }
     if (_module == MODULE_WIZE) {
-        if (dr > 3) return;
-    }
-
-    _setSlot(MEM_DATA_RATE, dr);
-    if (MODULE_WIZE == _module) {
-        _setSlot(MEM_DATA_RATE_RX, dr);
+        if (dr > 3) return 0xFF;
     }
+    return dr;
 
 }
 
@@ -680,13 +1245,7 @@ uint8_t AllWize::getDataRate() {
  */
 void AllWize::setMode(uint8_t mode, bool persist) {
 
-    // Wize FW accepts only modes 0x10 and 0x11
-    if (MODULE_WIZE == _module) {
-        if ((MBUS_MODE_N1 != mode) && (MBUS_MODE_N2 != mode)) return;
-    }
-    
-    // Only OSP FW accepts mode 0x12
-    if ((MBUS_MODE_OSP == mode) && (MODULE_OSP != _module)) return;
+    if (!_modeAllowed(mode)) return;
 
     if (persist) {
         _setSlot(MEM_MBUS_MODE, mode);
@@ -696,6 +1255,26 @@ void AllWize::setMode(uint8_t mode, bool persist) {
 
 }
 
+/**
+ * @brief               Checks if the module firmware accepts an MBus mode
+ * @param mode          MBus mode (MBUS_MODE_*)
+ * @return              True if the mode can be set
+ * @protected
+ */
+bool AllWize::_modeAllowed(uint8_t mode) {
+
+    // Wize FW accepts only modes 0x10 and 0x11
+    if (MODULE_WIZE == _module) {
+        if ((MBUS_MODE_N1 != mode) && (MBUS_MODE_N2 != mode)) return false;
+    }
+    
+    // Only OSP FW accepts mode 0x12
+    if ((MBUS_MODE_OSP == mode) && (MODULE_OSP != _module)) return false;
+
+    return true;
+
+}
+
 /**
  * @brief               Gets the MBus mode stored in non-volatile memory
  * @return              MBus mode (1 byte)
@@ -972,6 +1551,26 @@ void AllWize::setBaudRate(uint8_t value) {
     }
 }
 
+/**
+ * @brief               Switches the module and the host UART to the highest baud rate up to max
+ *                      that works, falling back to the current one (or the default one) otherwise.
+ *                      The new baud rate is persisted in the module.
+ * @param max           Highest baud rate to try (BAUDRATE_*)
+ * @return              Baud rate in use after the negotiation (BAUDRATE_*)
+ */
+uint8_t AllWize::negotiateBaudRate(uint8_t max) {
+
+    uint8_t current = _getBaudRateCode();
+    if (max > BAUDRATE_COUNT) max = BAUDRATE_COUNT;
+
+    for (uint8_t value = max; value > current; value--) {
+        if (_tryBaudRate(value)) return value;
+        if (BAUDRATES[current-1] != _baudrate) return _getBaudRateCode();
+    }
+    return current;
+
+}
+
 /**
  * @brief               Gets the UART baud rate
  * @return              Value (1 byte)
@@ -992,6 +1591,16 @@ uint32_t AllWize::getBaudRateSpeed(uint8_t value) {
     return 0;
 }
 
+/**
+ * @brief               Returns the average speed of the reads from the module since boot,
+ *                      including the time the module takes to respond
+ * @return              Bytes per second
+ */
+uint32_t AllWize::getReadRate() {
+    if (0 == _read_us) return 0;
+    return (uint64_t) _read_bytes * 1000000 / _read_us;
+}
+
 // -----------------------------------------------------------------------------
 
 /**
@@ -1001,7 +1610,7 @@ uint32_t AllWize::getBaudRateSpeed(uint8_t value) {
  */
 float AllWize::getRSSI() {
     uint8_t response = _sendCommand(CMD_RSSI);
-    if (response > 0) return -0.5 * (float) _buffer[0];
+    if (response > 0) return -0.5 * (float) _response[0];
     return 0;
 }
 
@@ -1014,7 +1623,7 @@ uint8_t AllWize::getTemperature() {
     uint8_t ret_val = 0;
 
     if (response > 0) {
-        ret_val = _buffer[0] - 128;
+        ret_val = _response[0] - 128;
     } else {
         ret_val = 0;
     }
@@ -1030,7 +1639,7 @@ uint16_t AllWize::getVoltage() {
     uint8_t response = _sendCommand(CMD_VOLTAGE);
     uint16_t ret_val;
     if (response > 0) {
-        ret_val = 30 * _buffer[0];
+        ret_val = 30 * _response[0];
     } else {
         ret_val = 0;
     }
@@ -1046,6 +1655,16 @@ String AllWize::getMID() {
     return _getSlotAsHexString(MEM_MANUFACTURER_ID, 2);
 }
 
+/**
+ * @brief               Returns the Manufacturer ID without allocating memory
+ * @param buffer        Buffer to store the 4 char hex string (5 bytes including the terminator)
+ * @param size          Size of the buffer
+ * @return              True if successfully read
+ */
+bool AllWize::getMID(char * buffer, size_t size) {
+    return _getSlotAsHexString(MEM_MANUFACTURER_ID, 2, buffer, size);
+}
+
 /**
  * @brief               Sets the Manufacturer ID
  * @param mid           MID to save
@@ -1065,6 +1684,16 @@ String AllWize::getUID() {
     return _getSlotAsHexString(MEM_UNIQUE_ID, 4);
 }
 
+/**
+ * @brief               Returns the Unique ID string without allocating memory
+ * @param buffer        Buffer to store the 8 char hex string (9 bytes including the terminator)
+ * @param size          Size of the buffer
+ * @return              True if successfully read
+ */
+bool AllWize::getUID(char * buffer, size_t size) {
+    return _getSlotAsHexString(MEM_UNIQUE_ID, 4, buffer, size);
+}
+
 /**
  * @brief               Saved the UID into the module memory
  * @param uid           UID to save
@@ -1115,7 +1744,19 @@ void AllWize::setDevice(uint8_t type) {
  * @return              12-byte hex string with the part number
  */
 String AllWize::getPartNumber() {
-    return _model;
+    if (0 == _model[0]) _readModel();
+    return String(_model);
+}
+
+/**
+ * @brief               Returns the module part number without allocating memory
+ * @param buffer        Buffer to store the part number
+ * @param size          Size of the buffer
+ * @return              True if the buffer was big enough
+ */
+bool AllWize::getPartNumber(char * buffer, size_t size) {
+    if (0 == _model[0]) _readModel();
+    return _copyString(_model, buffer, size);
 }
 
 /**
@@ -1123,7 +1764,19 @@ String AllWize::getPartNumber() {
  * @return              4-byte hex string with the HW version
  */
 String AllWize::getRequiredHardwareVersion() {
-    return _hw;
+    if (0 == _model[0]) _readModel();
+    return String(_hw);
+}
+
+/**
+ * @brief               Returns the minimum required hardware version without allocating memory
+ * @param buffer        Buffer to store the HW version
+ * @param size          Size of the buffer
+ * @return              True if the buffer was big enough
+ */
+bool AllWize::getRequiredHardwareVersion(char * buffer, size_t size) {
+    if (0 == _model[0]) _readModel();
+    return _copyString(_hw, buffer, size);
 }
 
 /**
@@ -1131,7 +1784,19 @@ String AllWize::getRequiredHardwareVersion() {
  * @return              4-byte hex string with the FW version
  */
 String AllWize::getFirmwareVersion() {
-    return _fw;
+    if (0 == _model[0]) _readModel();
+    return String(_fw);
+}
+
+/**
+ * @brief               Returns the module firmware revision without allocating memory
+ * @param buffer        Buffer to store the FW version
+ * @param size          Size of the buffer
+ * @return              True if the buffer was big enough
+ */
+bool AllWize::getFirmwareVersion(char * buffer, size_t size) {
+    if (0 == _model[0]) _readModel();
+    return _copyString(_fw, buffer, size);
 }
 
 /**
@@ -1142,6 +1807,16 @@ String AllWize::getSerialNumber() {
     return _getSlotAsHexString(MEM_SERIAL_NUMBER, 8);
 }
 
+/**
+ * @brief               Returns the module serial number without allocating memory
+ * @param buffer        Buffer to store the 16 char hex string (17 bytes including the terminator)
+ * @param size          Size of the buffer
+ * @return              True if successfully read
+ */
+bool AllWize::getSerialNumber(char * buffer, size_t size) {
+    return _getSlotAsHexString(MEM_SERIAL_NUMBER, 8, buffer, size);
+}
+
 /**
  * @brief               Returns the module type
  * @return              One of MODULE_UNKNOWN, MODULE_MBUS4, MODULE_OSP and MODULE_WIZE
@@ -1163,6 +1838,21 @@ String AllWize::getModuleTypeName() {
     return String("Unknown");
 }
 
+/**
+ * @brief               Returns the module type name without allocating memory
+ * @param buffer        Buffer to store the name
+ * @param size          Size of the buffer
+ * @return              True if the buffer was big enough
+ */
+bool AllWize::getModuleTypeName(char * buffer, size_t size) {
+    switch (_module) {
+        case MODULE_MBUS4: return _copyString("MBUS4", buffer, size);
+        case MODULE_OSP: return _copyString("OSP", buffer, size);
+        case MODULE_WIZE: return _copyString("WIZE", buffer, size);
+    }
+    return _copyString("Unknown", buffer, size);
+}
+
 
 /**
  * @brief               Returns the frequency for the given channel
@@ -1213,6 +1903,8 @@ uint16_t AllWize::getDataRateSpeed(uint8_t dr) {
  * @protected
 */
 bool AllWize::_setConfig(bool value) {
+    while (poll());
+    if (!value && (_config_depth > 0)) return _config;
     if (value != _config) {
         _flush();
         if (value) {
@@ -1235,19 +1927,25 @@ bool AllWize::_setConfig(bool value) {
 }
 
 /**
- * @brief               Sends a command with the given data
+ * @brief               Sends a command with the given data and waits for the response
  * @param command       Command key
  * @param data          Binary data to send
  * @param len           Length of the binary data
+ * @return              Number of bytes received, -1 if timed out or error sending
  * @protected
  */
 int8_t AllWize::_sendCommand(uint8_t command, uint8_t *data, uint8_t len) {
     int8_t response = -1;
-    if (!_setConfig(true)) return response;
-    if (_sendAndReceive(command) != -1) {
-        response = _sendAndReceive(data, len);
+    while (poll());
+    if (_commandStart(command, data, len, NULL, NULL)) {
+        while (poll()) {
+            #if defined(ARDUINO_ARCH_ESP8266)
+                yield();
+            #endif
+        }
+        response = _cmd_result;
     }
-    _setConfig(false);
+    if (-1 == response) _config_errors++;
     return response;
 }
 
@@ -1259,13 +1957,7 @@ int8_t AllWize::_sendCommand(uint8_t command, uint8_t *data, uint8_t len) {
  * @protected
  */
 int8_t AllWize::_sendCommand(uint8_t command, uint8_t data) {
-    int8_t response = -1;
-    if (!_setConfig(true)) return response;
-    if (_sendAndReceive(command) != -1) {
-        response = _sendAndReceive(data);
-    }
-    _setConfig(false);
-    return response;
+    return _sendCommand(command, &data, 1);
 }
 
 /**
@@ -1275,17 +1967,238 @@ int8_t AllWize::_sendCommand(uint8_t command, uint8_t data) {
  * @protected
  */
 int8_t AllWize::_sendCommand(uint8_t command) {
-    int8_t response = -1;
-    if (!_setConfig(true)) return response;
-    response = _sendAndReceive(command);
-    _setConfig(false);
-    return response;
+    return _sendCommand(command, NULL, 0);
 }
 
-// ------------------------------------------------------------------------------------------------
-
 /**
- * @brief               Reads and caches the module memory
+ * @brief               Starts a command, entering config mode if not already there
+ * @param command       Command key
+ * @param data          Binary data to send, must be valid until the command is done
+ * @param len           Length of the binary data
+ * @param callback      Function to call when done
+ * @param ctx           User pointer passed to the callback
+ * @return              True if started, false if there is another command in flight
+ * @protected
+ */
+bool AllWize::_commandStart(uint8_t command, const uint8_t * data, uint8_t len, allwize_command_callback_t callback, void * ctx) {
+
+    if (COMMAND_STATE_IDLE != _cmd_state) return false;
+
+    _cmd_command = command;
+    _cmd_data = data;
+    _cmd_len = len;
+    _cmd_callback = callback;
+    _cmd_callback_ctx = ctx;
+    _cmd_count = 0;
+    _cmd_result = -1;
+    _cmd_last = millis();
+
+    if (!_config) {
+        _flush();
+        if (GPIO_NONE == _config_gpio) {
+            _send(CMD_ENTER_CONFIG);
+            _cmd_state = COMMAND_STATE_ENTER;
+            return true;
+        }
+        digitalWrite(_config_gpio, HIGH);
+        _config = true;
+    }
+
+    _send(_cmd_command);
+    _cmd_state = (_cmd_len > 0) ? COMMAND_STATE_PROMPT : COMMAND_STATE_RESPONSE;
+    return true;
+
+}
+
+/**
+ * @brief               Leaves config mode after a command, unless in a config transaction
+ * @protected
+ */
+void AllWize::_commandExit() {
+    if (_config_depth > 0) {
+        _commandDone();
+        return;
+    }
+    _flush();
+    if (GPIO_NONE != _config_gpio) {
+        digitalWrite(_config_gpio, LOW);
+    }
+    _send(CMD_EXIT_CONFIG);
+    _config = false;
+    _cmd_last = millis();
+    _cmd_state = COMMAND_STATE_EXIT;
+}
+
+/**
+ * @brief               Finishes the current command and calls its callback
+ * @protected
+ */
+void AllWize::_commandDone() {
+    _cmd_state = COMMAND_STATE_IDLE;
+    allwize_command_callback_t callback = _cmd_callback;
+    _cmd_callback = NULL;
+    if (callback) callback(_cmd_result, _response, _cmd_callback_ctx);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief               Returns the code of the baud rate in use
+ * @return              Baud rate (BAUDRATE_*), MODEM_DEFAULT_BAUDRATE if unknown
+ * @protected
+ */
+uint8_t AllWize::_getBaudRateCode() {
+    for (uint8_t i = 0; i < BAUDRATE_COUNT; i++) {
+        if (BAUDRATES[i] == _baudrate) return i + 1;
+    }
+    return MODEM_DEFAULT_BAUDRATE;
+}
+
+/**
+ * @brief               Resets the module using the reset GPIO or, if not available, the reset command.
+ *                      Does not wait for the module to be ready.
+ * @return              True if the module has been reset
+ * @protected
+ */
+bool AllWize::_resetModule() {
+    if (GPIO_NONE == _reset_gpio) {
+        _resetSerial();
+        waitForReady(RESET_TIMEOUT);
+        return _sendReset('R');
+    }
+    digitalWrite(_reset_gpio, LOW);
+    _niceDelay(1);
+    digitalWrite(_reset_gpio, HIGH);
+    if (GPIO_NONE != _config_gpio) {
+        digitalWrite(_config_gpio, LOW);
+    }
+    _config = false;
+    _config_depth = 0;
+    return true;
+}
+
+/**
+ * @brief               Sends a reset command (@R + type) to the module, does not wait for it to be ready
+ * @param type          'R' for a reset, 'C' for a factory reset
+ * @return              True if the command has been sent
+ * @protected
+ */
+bool AllWize::_sendReset(uint8_t type) {
+    _setSlot(MEM_CONFIG_INTERFACE, 1);
+    if (!_setConfig(true)) return false;
+    _send('@');
+    _send('R');
+    _send(type);
+    if (GPIO_NONE != _config_gpio) {
+        digitalWrite(_config_gpio, LOW);
+    }
+    _config = false;
+    _config_depth = 0;
+    return true;
+}
+
+/**
+ * @brief               Waits for the module to be ready after a reset, leaving it RESET_GUARD_TIME
+ *                      millis to reboot first so it does not answer the probe before rebooting
+ * @param timeout       Max time to wait in millis
+ * @return              True if the module is ready
+ * @protected
+ */
+bool AllWize::_waitForReset(uint32_t timeout) {
+    _niceDelay(RESET_GUARD_TIME);
+    return waitForReady(timeout);
+}
+
+/**
+ * @brief               Baud rate upgrade hooks for begin (see MODEM_UPGRADE_BAUDRATE)
+ * @param before        True before reading the module, to resync with a module that is 
+ *                      already running at the upgraded baud rate, false after reading it
+ *                      to negotiate the upgrade
+ * @protected
+ */
+void AllWize::_upgradeBaudRate(bool before) {
+    #if MODEM_UPGRADE_BAUDRATE
+        if (before) {
+            // After the first boot the module runs at the baud rate negotiated then,
+            // anything from MODEM_UPGRADE_BAUDRATE down to the requested one
+            uint8_t requested = _getBaudRateCode();
+            if (MODEM_UPGRADE_BAUDRATE > requested) {
+                _probeBaudRate(MODEM_UPGRADE_BAUDRATE, requested + 1);
+            }
+        } else if (MODULE_UNKNOWN != _module) {
+            negotiateBaudRate(MODEM_UPGRADE_BAUDRATE);
+        }
+    #else
+        (void) before;
+    #endif
+}
+
+/**
+ * @brief               Switches the module to the given baud rate and checks it answers.
+ *                      If it does not, the module is looked for at every baud rate and the
+ *                      previous one is saved back. If it cannot be found the host UART
+ *                      falls back to the default baud rate.
+ * @param value         Baud rate (BAUDRATE_*)
+ * @return              True if the module answers at the new baud rate
+ * @protected
+ */
+bool AllWize::_tryBaudRate(uint8_t value) {
+
+    uint8_t previous = _getBaudRateCode();
+
+    // Persist the new speed and reset the module so it uses it,
+    // then switch the host UART before waiting for the module
+    if (!_setSlot(MEM_UART_BAUD_RATE, value)) return false;
+    if (!_resetModule()) {
+        _setSlot(MEM_UART_BAUD_RATE, previous);
+        return false;
+    }
+    _baudrate = BAUDRATES[value-1];
+    _resetSerial();
+    if (_waitForReset(BAUDRATE_PROBE_TIMEOUT)) return true;
+
+    // The module may be running at any speed now, look for it and save
+    // the previous one back so it is not left at a speed the host cannot use
+    if (_probeBaudRate(BAUDRATE_COUNT, 1)) {
+        if (_setSlot(MEM_UART_BAUD_RATE, previous) && _resetModule()) {
+            _baudrate = BAUDRATES[previous-1];
+            _resetSerial();
+            if (_waitForReset(RESET_TIMEOUT)) return false;
+        }
+    }
+
+    // Last resort
+    _baudrate = BAUDRATES[MODEM_DEFAULT_BAUDRATE-1];
+    _resetSerial();
+    return false;
+
+}
+
+/**
+ * @brief               Looks for the baud rate the module answers at, from the highest given
+ *                      one down, and leaves the host UART at it
+ * @param from          Highest baud rate to probe (BAUDRATE_*)
+ * @param to            Lowest baud rate to probe (BAUDRATE_*)
+ * @return              Baud rate the module answers at, 0 if none (the host UART is not changed)
+ * @protected
+ */
+uint8_t AllWize::_probeBaudRate(uint8_t from, uint8_t to) {
+
+    uint32_t previous = _baudrate;
+    for (uint8_t value = from; (value >= to) && (value > 0); value--) {
+        _baudrate = BAUDRATES[value-1];
+        _resetSerial();
+        if (waitForReady(RESET_PROBE_TIMEOUT)) return value;
+    }
+
+    _baudrate = previous;
+    _resetSerial();
+    return 0;
+
+}
+
+/**
+ * @brief               Reads and caches the module memory
  * @param buffer        Buffer with at least 256 positions to hold memory
  * @return              True if successfully read
  * @protected
@@ -1301,45 +2214,163 @@ bool AllWize::_cacheMemory(uint8_t * buffer) {
 
 }
 
+/**
+ * @brief               Reads consecutive memory addresses from the module one by one
+ * @param address       Starting memory address
+ * @param buffer        Buffer with at least 'len' position to store data to
+ * @param len           Number of positions to read
+ * @return              Number of positions actually read
+ * @protected
+ */
+uint8_t AllWize::_readMemory(uint8_t address, uint8_t *buffer, uint8_t len) {
+    uint8_t count = 0;
+    if (_setConfig(true)) {
+        for (uint8_t i=0; i<len; i++) {
+            if (_sendAndReceive(CMD_READ_MEMORY) == -1) break;
+            if (_sendAndReceive(address + i) != 1) break;
+            count++;
+            buffer[i] = _response[0];
+        }
+        _setConfig(false);
+    }
+    return count;
+}
+
+#if USE_MEMORY_CACHE == MEMORY_CACHE_FULL
+
+/**
+ * @brief               Makes sure the memory cache pages for the given range are valid,
+ *                      reading the missing ones from the module
+ * @param address       Starting memory address
+ * @param len           Number of positions
+ * @return              True if the range is cached
+ * @protected
+ */
+bool AllWize::_fetchMemory(uint8_t address, uint16_t len) {
+
+    if (0 == len) return true;
+
+    // Look for missing pages
+    uint16_t pages = 0;
+    uint8_t missing = 0;
+    uint8_t last = (address + len - 1) / MEMORY_PAGE_SIZE;
+    for (uint8_t page = address / MEMORY_PAGE_SIZE; page <= last; page++) {
+        if (0 == (_memory_valid & (1 << page))) {
+            pages |= (1 << page);
+            missing++;
+        }
+    }
+    if (0 == missing) return true;
+
+    // Staged changes must reach the module before reading back the pages they are in,
+    // a full dump reads them all
+    bool dirty = (missing > MEMORY_DUMP_PAGES);
+    for (uint8_t page = 0; page < 0x100 / MEMORY_PAGE_SIZE; page++) {
+        if (0 == (pages & (1 << page))) continue;
+        for (uint8_t i = 0; i < MEMORY_PAGE_SIZE / 8; i++) {
+            if (_memory_dirty[page * MEMORY_PAGE_SIZE / 8 + i]) dirty = true;
+        }
+    }
+    if (dirty && !flushMemory()) return false;
+
+    // Dumping the whole memory is cheaper than reading many pages byte by byte
+    if (missing > MEMORY_DUMP_PAGES) {
+        if (!_cacheMemory(_memory)) return false;
+        _memory_valid = 0xFFFF;
+        return true;
+    }
+
+    for (uint8_t page = 0; page < 0x100 / MEMORY_PAGE_SIZE; page++) {
+        if (pages & (1 << page)) {
+            uint8_t start = page * MEMORY_PAGE_SIZE;
+            if (_readMemory(start, &_memory[start], MEMORY_PAGE_SIZE) != MEMORY_PAGE_SIZE) return false;
+            _memory_valid |= (1 << page);
+        }
+    }
+    return true;
+
+}
+
+#endif
+
 /**
  * @brief               Searches for the module model
  * @protected
  */
 void AllWize::_readModel() {
 
-    #if not USE_MEMORY_CACHE
-        uint8_t _memory[0x100] = {0xFF};
-        bool _ready = _cacheMemory(_memory);
-        if (!_ready) return;
-    #endif
-
-    // Look for the part_number
+    char part_number_buffer[33] = {0};
     bool found = false;
-    uint8_t index = 0;
     uint8_t len = strlen(MODULE_SIGNATURE);
-    for (index=0; index<0xFF-32; index++) {
-        if (memcmp(&_memory[index], (uint8_t *) MODULE_SIGNATURE, len) == 0) {
-            found = true;
+
+    // Check the known part number addresses first
+    uint8_t previous = 0xFF;
+    for (uint8_t module = 0; module < MODULE_MAX - 1; module++) {
+        uint8_t address = MEM_ADDRESS[module][MEM_PART_NUMBER];
+        if (address == previous) continue;
+        previous = address;
+        if (_readMemory(address, (uint8_t *) part_number_buffer, len) != len) return;
+        if (memcmp(part_number_buffer, MODULE_SIGNATURE, len) == 0) {
+            found = (_readMemory(address + len, (uint8_t *) &part_number_buffer[len], 32 - len) == 32 - len);
             break;
         }
     }
 
+    // Otherwise look for the part number in the whole memory, only when it is
+    // cached, other builds cannot afford a 256 bytes buffer and the model stays unknown
+    #if USE_MEMORY_CACHE == MEMORY_CACHE_FULL
+    if (!found) {
+
+        if (!_fetchMemory(0, 0x100)) return;
+
+        for (uint8_t index=0; index<0xFF-32; index++) {
+            if (memcmp(&_memory[index], (uint8_t *) MODULE_SIGNATURE, len) == 0) {
+                memcpy(part_number_buffer, &_memory[index], 32);
+                found = true;
+                break;
+            }
+        }
+
+    }
+    #endif
+
     // Parse signature
-    if (found) {
+    if (found) _parseModel(part_number_buffer);
 
-        String part_number = String((char *) &_memory[index]);
-        part_number.substring(0, 31);
-        part_number.trim();
+}
 
-        uint8_t end = part_number.indexOf(",");
-        _model = part_number.substring(0, end);
-        uint8_t start = end + 1;
-        end = part_number.indexOf(",", start);
-        _hw = part_number.substring(start, end);
-        _fw = part_number.substring(end + 1, 32);
-        _fw.trim();
+/**
+ * @brief               Splits the module signature ("part number,hw version,fw version")
+ *                      into the model fields in a single pass, trimming whitespace.
+ *                      Fields that do not fit are truncated.
+ * @param signature     Null terminated signature
+ * @protected
+ */
+void AllWize::_parseModel(const char * signature) {
 
+    char * fields[3] = { _model, _hw, _fw };
+    const uint8_t sizes[3] = { sizeof(_model), sizeof(_hw), sizeof(_fw) };
+    uint8_t field = 0;
+    uint8_t len = 0;
+    uint8_t trimmed = 0;
+
+    for (uint8_t i=0; i<3; i++) fields[i][0] = 0;
+
+    for (; *signature; signature++) {
+        char ch = *signature;
+        if ((',' == ch) && (field < 2)) {
+            fields[field][trimmed] = 0;
+            field++;
+            len = trimmed = 0;
+            continue;
+        }
+        if ((0 == len) && isspace((uint8_t) ch)) continue;
+        if (len < sizes[field] - 1) {
+            fields[field][len++] = ch;
+            if (!isspace((uint8_t) ch)) trimmed = len;
+        }
     }
+    fields[field][trimmed] = 0;
 
 }
 
@@ -1352,22 +2383,12 @@ void AllWize::_readModel() {
  * @protected
  */
 uint8_t AllWize::_getMemory(uint8_t address, uint8_t *buffer, uint8_t len) {
-    #if USE_MEMORY_CACHE
-        if (!_ready) return 0;
+    #if USE_MEMORY_CACHE == MEMORY_CACHE_FULL
+        if (!_fetchMemory(address, len)) return 0;
         memcpy(buffer, &_memory[address], len);
         return len;
     #else
-        uint8_t count = 0;
-        if (_setConfig(true)) {
-            for (uint8_t i=0; i<len; i++) {
-                if (_sendAndReceive(CMD_READ_MEMORY) == -1) break;
-                if (_sendAndReceive(address + i) != 1) break;
-                count++;
-                buffer[i] = _buffer[0];
-            }
-            _setConfig(false);
-        }
-        return count;
+        return _readMemory(address, buffer, len);
     #endif
 }
 
@@ -1378,47 +2399,33 @@ uint8_t AllWize::_getMemory(uint8_t address, uint8_t *buffer, uint8_t len) {
  * @protected
  */
 uint8_t AllWize::_getMemory(uint8_t address) {
-    #if USE_MEMORY_CACHE
-        if (!_ready) return 0;
+    #if USE_MEMORY_CACHE == MEMORY_CACHE_FULL
+        if (!_fetchMemory(address, 1)) return 0;
         return _memory[address];
     #else
         uint8_t response = _sendCommand(CMD_READ_MEMORY, address);
-        if (response > 0) return _buffer[0];
+        if (response > 0) return _response[0];
         return 0;
     #endif
 }
 
 /**
  * @brief               Sets non-volatile memory contents starting from given address
+ *                      With the memory cache enabled changes are staged and written
+ *                      right away or when the config transaction is committed
  * @param address       Memory address
  * @param data          Single byte to store at given address
  * @return              True if the data was successfully saved
  * @protected
  */
 bool AllWize::_setMemory(uint8_t address, uint8_t data) {
-
-    // Check cached data
-    #if USE_MEMORY_CACHE
-        if (_memory[address] == data) return true;
-    #endif
-
-    // Build query buffer
-    uint8_t buffer[3] = {address, data, (uint8_t)CMD_EXIT_MEMORY};
-    
-    // Execute command
-    bool ret = (_sendCommand(CMD_WRITE_MEMORY, buffer, 3) != -1);
-
-    // Update cached memory
-    #if USE_MEMORY_CACHE
-        if (ret) _memory[address] = data;
-    #endif
-
-    return ret;
-
+    return _setMemory(address, &data, 1);
 }
 
 /**
  * @brief               Sets non-volatile memory contents starting from given address
+ *                      With the memory cache enabled changes are staged and written
+ *                      right away or when the config transaction is committed
  * @param address       Memory address
  * @param data          Binary data to store
  * @param len           Length of the binary data
@@ -1427,28 +2434,37 @@ bool AllWize::_setMemory(uint8_t address, uint8_t data) {
  */
 bool AllWize::_setMemory(uint8_t address, uint8_t *data, uint8_t len) {
     
-    // Check cached data
-    #if USE_MEMORY_CACHE
-        if (memcmp(&_memory[address], data, len) == 0) return true;
-    #endif
+    #if USE_MEMORY_CACHE == MEMORY_CACHE_FULL
+
+        // Stage changed positions, all of them if their page is not cached
+        // (reading the page first would cost two round trips per byte)
+        for (uint8_t i = 0; i < len; i++) {
+            uint8_t position = address + i;
+            bool valid = (_memory_valid & (1 << (position / MEMORY_PAGE_SIZE)));
+            if (!valid || (_memory[position] != data[i])) {
+                _memory[position] = data[i];
+                _memory_dirty[position >> 3] |= (1 << (position & 0x07));
+            }
+        }
 
-    // Build query buffer
-    uint8_t buffer[len * 2 + 1];
-    for (uint8_t i = 0; i < len; i++) { 
-        buffer[i * 2] = address + i;
-        buffer[i * 2 + 1] = data[i];
-    }
-    buffer[len * 2] = CMD_EXIT_MEMORY;
-    
-    // Execute command
-    bool ret = (_sendCommand(CMD_WRITE_MEMORY, buffer, len * 2 + 1) != -1);
-    
-    // Update cached memory
-    #if USE_MEMORY_CACHE
-        if (ret) memcpy(&_memory[address], data, len);
-    #endif
+        // Flush now unless in a config transaction
+        if (_config_depth > 0) return true;
+        return flushMemory();
 
-    return ret;
+    #else
+
+        // Build query buffer
+        uint8_t buffer[len * 2 + 1];
+        for (uint8_t i = 0; i < len; i++) { 
+            buffer[i * 2] = address + i;
+            buffer[i * 2 + 1] = data[i];
+        }
+        buffer[len * 2] = CMD_EXIT_MEMORY;
+        
+        // Execute command
+        return (_sendCommand(CMD_WRITE_MEMORY, buffer, len * 2 + 1) != -1);
+
+    #endif
 
 }
 
@@ -1491,7 +2507,32 @@ bool AllWize::_setSlot(uint8_t slot, uint8_t *data, uint8_t len) {
 bool AllWize::_setSlot(uint8_t slot, uint8_t data) {
     uint8_t address = _getAddress(slot);
     if (0xFF == address) return false;
-    return _setMemory(address, data);
+    return _setSlotAt(slot, address, data);
+}
+
+/**
+ * @brief               Sets a single-byte memory slot whose address is already known,
+ *                      keeping the slot cache up to date
+ * @param slot          Memory slot
+ * @param address       Memory address of the slot
+ * @param data          Single byte to store
+ * @return              True if the data was successfully saved
+ * @protected
+ */
+bool AllWize::_setSlotAt(uint8_t slot, uint8_t address, uint8_t data) {
+    bool ret = _setMemory(address, data);
+    #if USE_MEMORY_CACHE == MEMORY_CACHE_SLOTS
+        int8_t index = _slotCacheIndex(slot);
+        if (index >= 0) {
+            if (ret) {
+                _slot_cache[index] = data;
+                _slot_valid |= (1 << index);
+            } else {
+                _slot_valid &= ~(1 << index);
+            }
+        }
+    #endif
+    return ret;
 }
 
 /**
@@ -1517,9 +2558,53 @@ uint8_t AllWize::_getSlot(uint8_t slot, uint8_t *buffer, uint8_t len) {
 uint8_t AllWize::_getSlot(uint8_t slot) {
     uint8_t address = _getAddress(slot);
     if (0xFF == address) return 0;
+    return _getSlotAt(slot, address);
+}
+
+/**
+ * @brief               Returns the contents of a single-byte memory slot whose address is already known
+ * @param slot          Memory slot
+ * @param address       Memory address of the slot
+ * @return              Contents of the slot, 0 if error
+ * @protected
+ */
+uint8_t AllWize::_getSlotAt(uint8_t slot, uint8_t address) {
+    #if USE_MEMORY_CACHE == MEMORY_CACHE_SLOTS
+        int8_t index = _slotCacheIndex(slot);
+        if (index >= 0) {
+            if (0 == (_slot_valid & (1 << index))) {
+                if (_readMemory(address, &_slot_cache[index], 1) != 1) return 0;
+                _slot_valid |= (1 << index);
+            }
+            return _slot_cache[index];
+        }
+    #endif
     return _getMemory(address);
 }
 
+#if USE_MEMORY_CACHE == MEMORY_CACHE_SLOTS
+
+// Slots cached with the MEMORY_CACHE_SLOTS policy, the ones begin() and applyProfile() read
+static const uint8_t MEMORY_CACHE_SLOTS_LIST[MEMORY_CACHE_SLOT_COUNT] = {
+    MEM_MBUS_MODE, MEM_DATA_INTERFACE, MEM_RSSI_MODE, MEM_CHANNEL,
+    MEM_RF_POWER, MEM_DATA_RATE, MEM_NETWORK_ROLE
+};
+
+/**
+ * @brief               Returns the position of a slot in the slot cache
+ * @param slot          Memory slot
+ * @return              Position in the slot cache, -1 if the slot is not cached
+ * @protected
+ */
+int8_t AllWize::_slotCacheIndex(uint8_t slot) {
+    for (uint8_t i = 0; i < MEMORY_CACHE_SLOT_COUNT; i++) {
+        if (MEMORY_CACHE_SLOTS_LIST[i] == slot) return i;
+    }
+    return -1;
+}
+
+#endif
+
 /**
  * @brief               Returns the contents of the memory from a certain address as an HEX String
  * @param slot          Memory slot
@@ -1528,15 +2613,45 @@ uint8_t AllWize::_getSlot(uint8_t slot) {
  * @protected
  */
 String AllWize::_getSlotAsHexString(uint8_t slot, uint8_t len) {
-    uint8_t bin[len];
     char hex[2 * len + 1];
-    hex[0] = 0;
-    if (len == _getSlot(slot, bin, len)) {
-        _bin2hex(bin, hex, len);
-    }
+    _getSlotAsHexString(slot, len, hex, sizeof(hex));
     return String(hex);
 }
 
+/**
+ * @brief               Returns the contents of the memory from a certain address as an HEX c-string
+ * @param slot          Memory slot
+ * @param len           Number of bytes to read
+ * @param buffer        Buffer to store the string, at least 2 * len + 1 bytes
+ * @param size          Size of the buffer
+ * @return              True if successfully read (empty string otherwise)
+ * @protected
+ */
+bool AllWize::_getSlotAsHexString(uint8_t slot, uint8_t len, char * buffer, size_t size) {
+    if (size < 1) return false;
+    buffer[0] = 0;
+    if (size < (size_t) 2 * len + 1) return false;
+    uint8_t bin[len];
+    if (len != _getSlot(slot, bin, len)) return false;
+    _bin2hex(bin, buffer, len);
+    return true;
+}
+
+/**
+ * @brief               Copies a c-string into a buffer
+ * @param value         C-string to copy
+ * @param buffer        Buffer to copy the string to
+ * @param size          Size of the buffer
+ * @return              True if the buffer was big enough (the string is truncated otherwise)
+ * @protected
+ */
+bool AllWize::_copyString(const char * value, char * buffer, size_t size) {
+    if (size < 1) return false;
+    strncpy(buffer, value, size - 1);
+    buffer[size - 1] = 0;
+    return strlen(value) < size;
+}
+
 /**
  * @brief               Returns the contents of the memory from a certain address as a String object
  * @param slot          Memory slot
@@ -1557,6 +2672,60 @@ String AllWize::_getSlotAsString(uint8_t slot, uint8_t len) {
 
 // ------------------------------------------------------------------------------------------------
 
+/**
+ * @brief               Feeds a byte to the RX state machine
+ * @param ch            Byte received from the module
+ * @return              True if the byte completes a frame in the RX buffer
+ * @protected
+ */
+bool AllWize::_parse(uint8_t ch) {
+
+    bool has_start = (getDataInterface() & 0x04) == 0x04;
+
+    // New frame
+    if ((0 == _pointer) && (RX_STATE_SKIP != _rx_state)) {
+        _rx_state = has_start ? RX_STATE_START : RX_STATE_LENGTH;
+    }
+
+    switch (_rx_state) {
+
+        // Discard everything until a start byte arrives
+        case RX_STATE_START:
+            if (START_BYTE != ch) return false;
+            _buffer[_pointer++] = ch;
+            _rx_state = RX_STATE_LENGTH;
+            return false;
+
+        // Length byte tells how many more bytes to expect (stop byte not included)
+        case RX_STATE_LENGTH:
+            _buffer[_pointer++] = ch;
+            _rx_expected = _pointer + ch + (has_start ? 1 : 0);
+            if (_rx_expected > RX_BUFFER_SIZE) {
+                // Does not fit, consume the announced bytes before looking for a new frame
+                _rx_expected -= _pointer;
+                _pointer = 0;
+                _rx_state = RX_STATE_SKIP;
+                _oversized_frames++;
+                return false;
+            }
+            _rx_state = RX_STATE_DATA;
+            break;
+
+        // Discard the rest of a frame too long for the RX buffer
+        case RX_STATE_SKIP:
+            if (0 == --_rx_expected) _rx_state = RX_STATE_START;
+            return false;
+
+        default:
+            _buffer[_pointer++] = ch;
+            break;
+
+    }
+
+    return (_pointer == _rx_expected);
+
+}
+
 /**
  * @brief               Decodes the current RX buffer contents
  * @return              Whether the contents are a valid packet
@@ -1572,7 +2741,7 @@ String AllWize::_getSlotAsString(uint8_t slot, uint8_t len) {
  * 4. Control info (1-byte)    | * | * | * | * | * | * |
  * 5. App data (n-bytes)       | * | * | * | * | * | * |
  * 6. RSSI (1-byte)            | - | - | - | - | - | - |
- * 7. CRC (2-bytes)            |   |   |   |   | * | * |
+ * 7. CRC (2-bytes)            |   |   |   |   | * | * | from section 1 to 5
  * 8. Stop byte (0x16)         |   |   |   | * |   | * |
  *
  * Note:
@@ -1620,96 +2789,648 @@ bool AllWize::_decode() {
     uint8_t len = _buffer[in++];
     if (_pointer != len + bytes_not_in_len) return false;
 
+    // Stop byte
+    if (has_start) {
+        if (STOP_BYTE != _buffer[_pointer - 1]) return false;
+    }
+
+    // CRC, from the length byte to the end of the application data, MSB first
+    bool crc_ok = true;
+    if (has_crc) {
+        uint8_t crc_pos = _pointer - (has_start ? 3 : 2);
+        uint8_t crc_len = crc_pos - (has_rssi ? 1 : 0) - (in - 1);
+        uint16_t crc = (_buffer[crc_pos] << 8) + _buffer[crc_pos + 1];
+        crc_ok = (_crc16(&_buffer[in - 1], crc_len) == crc);
+        if (!crc_ok) {
+            _crc_errors++;
+            #if CRC_DROP_INVALID
+                return false;
+            #endif
+        }
+    }
+
+    // Wize transport layer
+    uint8_t ci = _buffer[in + (has_header ? 9 : 0)];
+    bool has_wize = (MODULE_WIZE == _module) && (CI_WIZE == ci);
+    if (MODULE_WIZE == _module) {
+        if (has_wize) {
+            bytes_not_in_app += 5;
+        } else {
+            // Undocumented hack 
+            bytes_not_in_msg = 8;
+        }
+    }
+    if (len < bytes_not_in_app + bytes_not_in_msg) return false;
+
+    // Device filter
+    uint32_t address = 0;
+    if (has_header) {
+        address = ((uint32_t) _buffer[in + 6] << 24) + ((uint32_t) _buffer[in + 5] << 16) + (_buffer[in + 4] << 8) + _buffer[in + 3];
+        if (!_filter(address)) return false;
+    }
+
+    // Duplicates
+    bool duplicate = false;
+    #if DEDUP_CACHE_SIZE > 0
+        bool dedup = has_header && has_wize;
+        uint16_t dedup_man = 0;
+        uint16_t dedup_counter = 0;
+        if (dedup) {
+            dedup_man = (_buffer[in + 2] << 8) + _buffer[in + 1];
+            dedup_counter = (_buffer[in + 13] << 8) + _buffer[in + 12];
+            duplicate = _duplicate(dedup_man, address, dedup_counter);
+            #if DEDUP_DROP
+                if (duplicate) return false;
+            #endif
+        }
+    #endif
+
+    // Frame is valid, get a slot in the queue for it
+    allwize_message_t * message = _queuePush();
+    if (NULL == message) return false;
+
+    // Only messages that got a slot are remembered, a dropped one can still come from a repeater
+    #if DEDUP_CACHE_SIZE > 0
+        if (dedup && !duplicate) _dedupRecord(dedup_man, address, dedup_counter);
+    #endif
+
     if (has_header) {
 
         // C-field
-        _message.c = _buffer[in++];
+        message->c = _buffer[in++];
 
         // Manufacturer
         uint16_t man = (_buffer[in + 1] << 8) + _buffer[in];
-        _message.man[0] = ((man >> 10) & 0x001F) + 64;
-        _message.man[1] = ((man >> 5) & 0x001F) + 64;
-        _message.man[2] = ((man >> 0) & 0x001F) + 64;
-        _message.man[3] = 0;
+        message->man[0] = ((man >> 10) & 0x001F) + 64;
+        message->man[1] = ((man >> 5) & 0x001F) + 64;
+        message->man[2] = ((man >> 0) & 0x001F) + 64;
+        message->man[3] = 0;
         in += 2;
 
         // Address
-        _message.address[0] = _buffer[in + 3];
-        _message.address[1] = _buffer[in + 2];
-        _message.address[2] = _buffer[in + 1];
-        _message.address[3] = _buffer[in + 0];
+        message->address[0] = _buffer[in + 3];
+        message->address[1] = _buffer[in + 2];
+        message->address[2] = _buffer[in + 1];
+        message->address[3] = _buffer[in + 0];
         in += 4;
 
         // Version
-        _message.version = _buffer[in++];
+        message->version = _buffer[in++];
 
         // Type
-        _message.type = _buffer[in++];
+        message->type = _buffer[in++];
 
     } else {
-        _message.c = 0xFF;
-        _message.type = 0;
-        _message.version = 0;
-        _message.man[0] = 0;
-        memset(_message.address, 0, 6);
+        message->c = 0xFF;
+        message->type = 0;
+        message->version = 0;
+        message->man[0] = 0;
+        memset(message->address, 0, sizeof(message->address));
     }
 
     // Control information
-    _message.ci = _buffer[in++];
+    message->ci = _buffer[in++];
 
     // Wize transport layer
-    if (MODULE_WIZE == _module) {
-        
-        if (CI_WIZE == _message.ci) {
+    if (has_wize) {
         
-            bytes_not_in_app += 5;
-            
-            // Wize control
-            _message.wize_control = _buffer[in++];
+        // Wize control
+        message->wize_control = _buffer[in++];
 
-            // Wize operator ID
-            _message.wize_network_id = _buffer[in++];
+        // Wize operator ID
+        message->wize_network_id = _buffer[in++];
 
-            // Wize counter
-            _message.wize_counter = (_buffer[in + 1] << 8) + _buffer[in];
-            in += 2;
+        // Wize counter
+        message->wize_counter = (_buffer[in + 1] << 8) + _buffer[in];
+        in += 2;
 
-            // Wize application
-            _message.wize_application = _buffer[in++];
+        // Wize application
+        message->wize_application = _buffer[in++];
 
-        } else {
-            
-            // Undocumented hack 
-            bytes_not_in_msg = 8;
-        
-        }
-    
     }
 
     // Application data
-    _message.len = len - bytes_not_in_app - bytes_not_in_msg;
-    memcpy(_message.data, &_buffer[in], _message.len);
-    _message.data[_message.len] = 0;
-    in += (_message.len + bytes_not_in_msg);
+    message->len = len - bytes_not_in_app - bytes_not_in_msg;
+    uint8_t payload = in;
+    in += (message->len + bytes_not_in_msg);
 
     // RSSI
     if (has_rssi) {
-        _message.rssi = _buffer[in++];
+        message->rssi = _buffer[in++];
     } else {
-        _message.rssi = 0xFF;
+        message->rssi = 0xFF;
     }
 
+    // Payload is null terminated, in place this overwrites the byte after it (already read)
+    #if RX_DECODE_IN_PLACE
+        message->data = &_buffer[payload];
+    #else
+        memcpy(message->data, &_buffer[payload], message->len);
+    #endif
+    message->data[message->len] = 0;
+
     // CRC
-    if (has_crc) {
-        in += 2;
+    message->crc_ok = crc_ok;
+
+    // Duplicates
+    message->duplicate = duplicate;
+
+    // Timestamps
+    message->first_byte_us = _rx_first_us;
+    message->last_byte_us = _rx_last_us;
+
+    _postDecode(message);
+
+    return true;
+
+}
+
+/**
+ * @brief               Checks a device address against the allow-list and the Bloom filter
+ * @param address       Device address
+ * @return              True if the message has to be accepted
+ * @protected
+ */
+bool AllWize::_filter(uint32_t address) {
+
+    bool enabled = false;
+    bool accept = false;
+
+    // Sorted allow-list, binary search
+    if (_filter_count > 0) {
+        enabled = true;
+        uint16_t low = 0;
+        uint16_t high = _filter_count;
+        while (low < high) {
+            uint16_t mid = low + (high - low) / 2;
+            if (_filter_addresses[mid] < address) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        accept = (low < _filter_count) && (_filter_addresses[low] == address);
     }
 
-    // Stop byte
-    if (has_start) {
-        if (STOP_BYTE != _buffer[in]) return false;
+    // Bloom filter
+    #if FILTER_BLOOM_BITS > 0
+        if (!accept && _filter_bloom_enabled) {
+            enabled = true;
+            uint32_t h1 = address * 2654435761UL;
+            uint32_t h2 = (address ^ (address >> 16)) * 2246822519UL | 1;
+            accept = true;
+            for (uint8_t i = 0; i < FILTER_BLOOM_HASHES; i++) {
+                uint32_t bit = (h1 + i * h2) % FILTER_BLOOM_BITS;
+                if (0 == (_filter_bloom[bit >> 3] & (1 << (bit & 0x07)))) {
+                    accept = false;
+                    break;
+                }
+            }
+        }
+    #endif
+
+    if (!enabled) return true;
+    if (accept) {
+        _filter_hits++;
+    } else {
+        _filter_misses++;
     }
+    return accept;
 
-    return true;
+}
+
+#if DEDUP_CACHE_SIZE > 0
+
+/**
+ * @brief               Returns the first duplicate cache entry to probe for a message
+ * @param man           Manufacturer ID
+ * @param address       Device address
+ * @param counter       Wize counter
+ * @return              Index in the duplicate cache
+ * @protected
+ */
+uint8_t AllWize::_dedupIndex(uint16_t man, uint32_t address, uint16_t counter) {
+    return (address ^ (address >> 16) ^ man ^ ((uint32_t) counter * 31)) % DEDUP_CACHE_SIZE;
+}
+
+/**
+ * @brief               Checks a message against the duplicate cache
+ *                      Open addressing with up to DEDUP_PROBES linear probes
+ * @param man           Manufacturer ID
+ * @param address       Device address
+ * @param counter       Wize counter
+ * @return              True if the message was already seen within the duplicate window
+ * @protected
+ */
+bool AllWize::_duplicate(uint16_t man, uint32_t address, uint16_t counter) {
+
+    uint32_t now = millis();
+    uint8_t index = _dedupIndex(man, address, counter);
+
+    for (uint8_t i = 0; (i < DEDUP_PROBES) && (i < DEDUP_CACHE_SIZE); i++) {
+        allwize_dedup_t * entry = &_dedup[(index + i) % DEDUP_CACHE_SIZE];
+        bool expired = !entry->used || (now - entry->when > _dedup_window);
+        if (!expired && (entry->man == man) && (entry->address == address) && (entry->counter == counter)) {
+            _duplicates++;
+            return true;
+        }
+    }
+
+    return false;
+
+}
+
+/**
+ * @brief               Adds a message to the duplicate cache, replacing the first
+ *                      expired entry or the oldest one among the probed ones
+ * @param man           Manufacturer ID
+ * @param address       Device address
+ * @param counter       Wize counter
+ * @protected
+ */
+void AllWize::_dedupRecord(uint16_t man, uint32_t address, uint16_t counter) {
+
+    uint32_t now = millis();
+    uint8_t index = _dedupIndex(man, address, counter);
+    allwize_dedup_t * replace = NULL;
+    uint32_t oldest = 0;
+
+    for (uint8_t i = 0; (i < DEDUP_PROBES) && (i < DEDUP_CACHE_SIZE); i++) {
+        allwize_dedup_t * entry = &_dedup[(index + i) % DEDUP_CACHE_SIZE];
+        uint32_t age = now - entry->when;
+        if (!entry->used || (age > _dedup_window)) age = 0xFFFFFFFF;
+        if ((NULL == replace) || (age > oldest)) {
+            replace = entry;
+            oldest = age;
+        }
+    }
+
+    replace->used = true;
+    replace->man = man;
+    replace->address = address;
+    replace->counter = counter;
+    replace->when = now;
+
+}
+
+#endif
+
+/**
+ * @brief               Hook called after a message has been decoded into the receive queue, does nothing by default
+ * @param message       Decoded message
+ * @protected
+ */
+void AllWize::_postDecode(allwize_message_t * message) {
+    (void) message;
+}
+
+// -----------------------------------------------------------------------------
+// Receive queue
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief               Reads the stream, decodes any complete frame and stores it in the receive queue
+ *                      or passes it to the onMessage callback
+ *                      Frames are delimited using the length byte (and start/stop bytes if enabled),
+ *                      the RX_FRAME_TIMEOUT silence gap is only used to resync after a broken frame
+ * @param stop_when_full Stop reading the stream when the receive queue gets full
+ * @return              Number of new messages received
+ * @protected
+ */
+uint8_t AllWize::_pump(bool stop_when_full) {
+
+    uint8_t count = 0;
+
+    // Bytes in the line are command responses while in a config transaction or running a command
+    if ((_config_depth > 0) || (COMMAND_STATE_IDLE != _cmd_state)) return count;
+
+    while (_stream->available()) {
+
+        // Leave the rest in the stream if there is no room for them
+        if (stop_when_full && (0 == _pointer) && (RX_QUEUE_SIZE == _queue_count)) break;
+
+        // The queued message payload lives in the receive buffer, do not overwrite it
+        #if RX_DECODE_IN_PLACE
+            if ((0 == _pointer) && (_queue_count > 0)) break;
+        #endif
+
+        uint8_t ch = _stream->read();
+
+        #if defined(ALLWIZE_DEBUG_PORT)
+        {
+            char buffer[10];
+            snprintf(buffer, sizeof(buffer), "r %02X '%c'", ch, (32 <= ch && ch <= 126) ? ch : 32);
+            ALLWIZE_DEBUG_PRINTLN(buffer);
+        }
+        #endif
+
+        _rx_last = millis();
+        _rx_last_us = micros();
+
+        #if defined(ARDUINO_ARCH_ESP8266)
+            yield();
+        #endif
+
+        // Check if message finished and decode it
+        bool complete = _parse(ch);
+        if (1 == _pointer) _rx_first_us = _rx_last_us;
+        if (complete) {
+
+            if (_decode()) {
+                count++;
+                _dispatch();
+            }
+            _length = _pointer;
+            _pointer = 0;
+
+            // If we don't soft-reset the line the RX channel gets stalled,
+            // in continuous RX mode keep reading and only kick it when stalled.
+            // Frames already in the stream are kept for readMany or the next call.
+            if (!_continuous_rx) {
+                _rx_reset_pending = true;
+                if (!stop_when_full) break;
+            }
+
+        }
+
+    }
+
+    // Incomplete frame, drop it and resync
+    bool partial = (_pointer > 0) || (RX_STATE_SKIP == _rx_state);
+    if (partial && (millis() - _rx_last > RX_FRAME_TIMEOUT)) {
+        _length = _pointer;
+        _pointer = 0;
+        _rx_state = RX_STATE_START;
+        _rx_reset_pending = true;
+    }
+
+    // Nothing heard for too long, kick the RX channel
+    if (_continuous_rx && (_rx_stall_timeout > 0) && (0 == _pointer)) {
+        if (millis() - _rx_last > _rx_stall_timeout) {
+            _rx_reset_pending = true;
+            _rx_last = millis();
+        }
+    }
+
+    // The config session would swallow any frame left in the stream
+    if (_rx_reset_pending && (0 == _stream->available())) softReset();
+
+    return count;
+
+}
+
+/**
+ * @brief               Passes all the messages in the receive queue to the onMessage callback, if any
+ * @protected
+ */
+void AllWize::_dispatch() {
+    if (NULL == _callback) return;
+    allwize_view_t view;
+    while (_queue_count > 0) {
+        _view(_queuePop(), view);
+        _callback(view, _callback_ctx);
+    }
+}
+
+/**
+ * @brief               Returns the next free slot in the receive queue and marks it as used
+ *                      If the queue is full the oldest message is discarded or NULL is returned
+ *                      depending on the current queue policy
+ * @return              Pointer to the slot, NULL if the new message has to be discarded
+ * @protected
+ */
+allwize_message_t * AllWize::_queuePush() {
+
+    if (RX_QUEUE_SIZE == _queue_count) {
+        _queue_overflows++;
+        if (RX_QUEUE_DROP_NEWEST == _queue_policy) return NULL;
+        _queue_tail = (_queue_tail + 1) % RX_QUEUE_SIZE;
+        _queue_count--;
+    }
+
+    allwize_message_t * message = &_queue[_queue_head];
+    _queue_head = (_queue_head + 1) % RX_QUEUE_SIZE;
+    _queue_count++;
+    return message;
+
+}
+
+/**
+ * @brief               Returns the oldest message in the receive queue and frees its slot
+ *                      The slot contents remain valid until a new message is pushed into it
+ *                      If the queue is empty the last message read is returned again
+ * @return              Pointer to the slot
+ * @protected
+ */
+allwize_message_t * AllWize::_queuePop() {
+
+    if (0 == _queue_count) {
+        return &_queue[(_queue_tail + RX_QUEUE_SIZE - 1) % RX_QUEUE_SIZE];
+    }
+
+    allwize_message_t * message = &_queue[_queue_tail];
+    _queue_tail = (_queue_tail + 1) % RX_QUEUE_SIZE;
+    _queue_count--;
+
+    #if RX_LATENCY_BUCKETS > 0
+    {
+        uint32_t ms = (micros() - message->first_byte_us) / 1000;
+        uint8_t bucket = 0;
+        while ((ms > 0) && (bucket < RX_LATENCY_BUCKETS - 1)) {
+            ms >>= 1;
+            bucket++;
+        }
+        _latency[bucket]++;
+    }
+    #endif
+
+    return message;
+
+}
+
+/**
+ * @brief               Fills a view with the header of the given message and a pointer to its payload
+ * @param message       Message in the receive queue
+ * @param view          View to fill
+ * @protected
+ */
+void AllWize::_view(const allwize_message_t * message, allwize_view_t & view) {
+    *static_cast<allwize_header_t *>(&view) = *message;
+    view.data = message->data;
+}
+
+// -----------------------------------------------------------------------------
+
+// EN 13757 CRC-16 lookup tables (polynomial 0x3D65)
+// CRC_TABLE[0] is the byte-wise table, CRC_TABLE[1..3] are only used when slicing by 4
+static const uint16_t CRC_TABLE[CRC_SLICE_BY][256] PROGMEM = {
+    {
+        0x0000, 0x3D65, 0x7ACA, 0x47AF, 0xF594, 0xC8F1, 0x8F5E, 0xB23B,
+        0xD64D, 0xEB28, 0xAC87, 0x91E2, 0x23D9, 0x1EBC, 0x5913, 0x6476,
+        0x91FF, 0xAC9A, 0xEB35, 0xD650, 0x646B, 0x590E, 0x1EA1, 0x23C4,
+        0x47B2, 0x7AD7, 0x3D78, 0x001D, 0xB226, 0x8F43, 0xC8EC, 0xF589,
+        0x1E9B, 0x23FE, 0x6451, 0x5934, 0xEB0F, 0xD66A, 0x91C5, 0xACA0,
+        0xC8D6, 0xF5B3, 0xB21C, 0x8F79, 0x3D42, 0x0027, 0x4788, 0x7AED,
+        0x8F64, 0xB201, 0xF5AE, 0xC8CB, 0x7AF0, 0x4795, 0x003A, 0x3D5F,
+        0x5929, 0x644C, 0x23E3, 0x1E86, 0xACBD, 0x91D8, 0xD677, 0xEB12,
+        0x3D36, 0x0053, 0x47FC, 0x7A99, 0xC8A2, 0xF5C7, 0xB268, 0x8F0D,
+        0xEB7B, 0xD61E, 0x91B1, 0xACD4, 0x1EEF, 0x238A, 0x6425, 0x5940,
+        0xACC9, 0x91AC, 0xD603, 0xEB66, 0x595D, 0x6438, 0x2397, 0x1EF2,
+        0x7A84, 0x47E1, 0x004E, 0x3D2B, 0x8F10, 0xB275, 0xF5DA, 0xC8BF,
+        0x23AD, 0x1EC8, 0x5967, 0x6402, 0xD639, 0xEB5C, 0xACF3, 0x9196,
+        0xF5E0, 0xC885, 0x8F2A, 0xB24F, 0x0074, 0x3D11, 0x7ABE, 0x47DB,
+        0xB252, 0x8F37, 0xC898, 0xF5FD, 0x47C6, 0x7AA3, 0x3D0C, 0x0069,
+        0x641F, 0x597A, 0x1ED5, 0x23B0, 0x918B, 0xACEE, 0xEB41, 0xD624,
+        0x7A6C, 0x4709, 0x00A6, 0x3DC3, 0x8FF8, 0xB29D, 0xF532, 0xC857,
+        0xAC21, 0x9144, 0xD6EB, 0xEB8E, 0x59B5, 0x64D0, 0x237F, 0x1E1A,
+        0xEB93, 0xD6F6, 0x9159, 0xAC3C, 0x1E07, 0x2362, 0x64CD, 0x59A8,
+        0x3DDE, 0x00BB, 0x4714, 0x7A71, 0xC84A, 0xF52F, 0xB280, 0x8FE5,
+        0x64F7, 0x5992, 0x1E3D, 0x2358, 0x9163, 0xAC06, 0xEBA9, 0xD6CC,
+        0xB2BA, 0x8FDF, 0xC870, 0xF515, 0x472E, 0x7A4B, 0x3DE4, 0x0081,
+        0xF508, 0xC86D, 0x8FC2, 0xB2A7, 0x009C, 0x3DF9, 0x7A56, 0x4733,
+        0x2345, 0x1E20, 0x598F, 0x64EA, 0xD6D1, 0xEBB4, 0xAC1B, 0x917E,
+        0x475A, 0x7A3F, 0x3D90, 0x00F5, 0xB2CE, 0x8FAB, 0xC804, 0xF561,
+        0x9117, 0xAC72, 0xEBDD, 0xD6B8, 0x6483, 0x59E6, 0x1E49, 0x232C,
+        0xD6A5, 0xEBC0, 0xAC6F, 0x910A, 0x2331, 0x1E54, 0x59FB, 0x649E,
+        0x00E8, 0x3D8D, 0x7A22, 0x4747, 0xF57C, 0xC819, 0x8FB6, 0xB2D3,
+        0x59C1, 0x64A4, 0x230B, 0x1E6E, 0xAC55, 0x9130, 0xD69F, 0xEBFA,
+        0x8F8C, 0xB2E9, 0xF546, 0xC823, 0x7A18, 0x477D, 0x00D2, 0x3DB7,
+        0xC83E, 0xF55B, 0xB2F4, 0x8F91, 0x3DAA, 0x00CF, 0x4760, 0x7A05,
+        0x1E73, 0x2316, 0x64B9, 0x59DC, 0xEBE7, 0xD682, 0x912D, 0xAC48
+    },
+    #if CRC_SLICE_BY == 4
+    {
+        0x0000, 0xF4D8, 0xD4D5, 0x200D, 0x94CF, 0x6017, 0x401A, 0xB4C2,
+        0x14FB, 0xE023, 0xC02E, 0x34F6, 0x8034, 0x74EC, 0x54E1, 0xA039,
+        0x29F6, 0xDD2E, 0xFD23, 0x09FB, 0xBD39, 0x49E1, 0x69EC, 0x9D34,
+        0x3D0D, 0xC9D5, 0xE9D8, 0x1D00, 0xA9C2, 0x5D1A, 0x7D17, 0x89CF,
+        0x53EC, 0xA734, 0x8739, 0x73E1, 0xC723, 0x33FB, 0x13F6, 0xE72E,
+        0x4717, 0xB3CF, 0x93C2, 0x671A, 0xD3D8, 0x2700, 0x070D, 0xF3D5,
+        0x7A1A, 0x8EC2, 0xAECF, 0x5A17, 0xEED5, 0x1A0D, 0x3A00, 0xCED8,
+        0x6EE1, 0x9A39, 0xBA34, 0x4EEC, 0xFA2E, 0x0EF6, 0x2EFB, 0xDA23,
+        0xA7D8, 0x5300, 0x730D, 0x87D5, 0x3317, 0xC7CF, 0xE7C2, 0x131A,
+        0xB323, 0x47FB, 0x67F6, 0x932E, 0x27EC, 0xD334, 0xF339, 0x07E1,
+        0x8E2E, 0x7AF6, 0x5AFB, 0xAE23, 0x1AE1, 0xEE39, 0xCE34, 0x3AEC,
+        0x9AD5, 0x6E0D, 0x4E00, 0xBAD8, 0x0E1A, 0xFAC2, 0xDACF, 0x2E17,
+        0xF434, 0x00EC, 0x20E1, 0xD439, 0x60FB, 0x9423, 0xB42E, 0x40F6,
+        0xE0CF, 0x1417, 0x341A, 0xC0C2, 0x7400, 0x80D8, 0xA0D5, 0x540D,
+        0xDDC2, 0x291A, 0x0917, 0xFDCF, 0x490D, 0xBDD5, 0x9DD8, 0x6900,
+        0xC939, 0x3DE1, 0x1DEC, 0xE934, 0x5DF6, 0xA92E, 0x8923, 0x7DFB,
+        0x72D5, 0x860D, 0xA600, 0x52D8, 0xE61A, 0x12C2, 0x32CF, 0xC617,
+        0x662E, 0x92F6, 0xB2FB, 0x4623, 0xF2E1, 0x0639, 0x2634, 0xD2EC,
+        0x5B23, 0xAFFB, 0x8FF6, 0x7B2E, 0xCFEC, 0x3B34, 0x1B39, 0xEFE1,
+        0x4FD8, 0xBB00, 0x9B0D, 0x6FD5, 0xDB17, 0x2FCF, 0x0FC2, 0xFB1A,
+        0x2139, 0xD5E1, 0xF5EC, 0x0134, 0xB5F6, 0x412E, 0x6123, 0x95FB,
+        0x35C2, 0xC11A, 0xE117, 0x15CF, 0xA10D, 0x55D5, 0x75D8, 0x8100,
+        0x08CF, 0xFC17, 0xDC1A, 0x28C2, 0x9C00, 0x68D8, 0x48D5, 0xBC0D,
+        0x1C34, 0xE8EC, 0xC8E1, 0x3C39, 0x88FB, 0x7C23, 0x5C2E, 0xA8F6,
+        0xD50D, 0x21D5, 0x01D8, 0xF500, 0x41C2, 0xB51A, 0x9517, 0x61CF,
+        0xC1F6, 0x352E, 0x1523, 0xE1FB, 0x5539, 0xA1E1, 0x81EC, 0x7534,
+        0xFCFB, 0x0823, 0x282E, 0xDCF6, 0x6834, 0x9CEC, 0xBCE1, 0x4839,
+        0xE800, 0x1CD8, 0x3CD5, 0xC80D, 0x7CCF, 0x8817, 0xA81A, 0x5CC2,
+        0x86E1, 0x7239, 0x5234, 0xA6EC, 0x122E, 0xE6F6, 0xC6FB, 0x3223,
+        0x921A, 0x66C2, 0x46CF, 0xB217, 0x06D5, 0xF20D, 0xD200, 0x26D8,
+        0xAF17, 0x5BCF, 0x7BC2, 0x8F1A, 0x3BD8, 0xCF00, 0xEF0D, 0x1BD5,
+        0xBBEC, 0x4F34, 0x6F39, 0x9BE1, 0x2F23, 0xDBFB, 0xFBF6, 0x0F2E
+    },
+    {
+        0x0000, 0xE5AA, 0xF631, 0x139B, 0xD107, 0x34AD, 0x2736, 0xC29C,
+        0x9F6B, 0x7AC1, 0x695A, 0x8CF0, 0x4E6C, 0xABC6, 0xB85D, 0x5DF7,
+        0x03B3, 0xE619, 0xF582, 0x1028, 0xD2B4, 0x371E, 0x2485, 0xC12F,
+        0x9CD8, 0x7972, 0x6AE9, 0x8F43, 0x4DDF, 0xA875, 0xBBEE, 0x5E44,
+        0x0766, 0xE2CC, 0xF157, 0x14FD, 0xD661, 0x33CB, 0x2050, 0xC5FA,
+        0x980D, 0x7DA7, 0x6E3C, 0x8B96, 0x490A, 0xACA0, 0xBF3B, 0x5A91,
+        0x04D5, 0xE17F, 0xF2E4, 0x174E, 0xD5D2, 0x3078, 0x23E3, 0xC649,
+        0x9BBE, 0x7E14, 0x6D8F, 0x8825, 0x4AB9, 0xAF13, 0xBC88, 0x5922,
+        0x0ECC, 0xEB66, 0xF8FD, 0x1D57, 0xDFCB, 0x3A61, 0x29FA, 0xCC50,
+        0x91A7, 0x740D, 0x6796, 0x823C, 0x40A0, 0xA50A, 0xB691, 0x533B,
+        0x0D7F, 0xE8D5, 0xFB4E, 0x1EE4, 0xDC78, 0x39D2, 0x2A49, 0xCFE3,
+        0x9214, 0x77BE, 0x6425, 0x818F, 0x4313, 0xA6B9, 0xB522, 0x5088,
+        0x09AA, 0xEC00, 0xFF9B, 0x1A31, 0xD8AD, 0x3D07, 0x2E9C, 0xCB36,
+        0x96C1, 0x736B, 0x60F0, 0x855A, 0x47C6, 0xA26C, 0xB1F7, 0x545D,
+        0x0A19, 0xEFB3, 0xFC28, 0x1982, 0xDB1E, 0x3EB4, 0x2D2F, 0xC885,
+        0x9572, 0x70D8, 0x6343, 0x86E9, 0x4475, 0xA1DF, 0xB244, 0x57EE,
+        0x1D98, 0xF832, 0xEBA9, 0x0E03, 0xCC9F, 0x2935, 0x3AAE, 0xDF04,
+        0x82F3, 0x6759, 0x74C2, 0x9168, 0x53F4, 0xB65E, 0xA5C5, 0x406F,
+        0x1E2B, 0xFB81, 0xE81A, 0x0DB0, 0xCF2C, 0x2A86, 0x391D, 0xDCB7,
+        0x8140, 0x64EA, 0x7771, 0x92DB, 0x5047, 0xB5ED, 0xA676, 0x43DC,
+        0x1AFE, 0xFF54, 0xECCF, 0x0965, 0xCBF9, 0x2E53, 0x3DC8, 0xD862,
+        0x8595, 0x603F, 0x73A4, 0x960E, 0x5492, 0xB138, 0xA2A3, 0x4709,
+        0x194D, 0xFCE7, 0xEF7C, 0x0AD6, 0xC84A, 0x2DE0, 0x3E7B, 0xDBD1,
+        0x8626, 0x638C, 0x7017, 0x95BD, 0x5721, 0xB28B, 0xA110, 0x44BA,
+        0x1354, 0xF6FE, 0xE565, 0x00CF, 0xC253, 0x27F9, 0x3462, 0xD1C8,
+        0x8C3F, 0x6995, 0x7A0E, 0x9FA4, 0x5D38, 0xB892, 0xAB09, 0x4EA3,
+        0x10E7, 0xF54D, 0xE6D6, 0x037C, 0xC1E0, 0x244A, 0x37D1, 0xD27B,
+        0x8F8C, 0x6A26, 0x79BD, 0x9C17, 0x5E8B, 0xBB21, 0xA8BA, 0x4D10,
+        0x1432, 0xF198, 0xE203, 0x07A9, 0xC535, 0x209F, 0x3304, 0xD6AE,
+        0x8B59, 0x6EF3, 0x7D68, 0x98C2, 0x5A5E, 0xBFF4, 0xAC6F, 0x49C5,
+        0x1781, 0xF22B, 0xE1B0, 0x041A, 0xC686, 0x232C, 0x30B7, 0xD51D,
+        0x88EA, 0x6D40, 0x7EDB, 0x9B71, 0x59ED, 0xBC47, 0xAFDC, 0x4A76
+    },
+    {
+        0x0000, 0x3B30, 0x7660, 0x4D50, 0xECC0, 0xD7F0, 0x9AA0, 0xA190,
+        0xE4E5, 0xDFD5, 0x9285, 0xA9B5, 0x0825, 0x3315, 0x7E45, 0x4575,
+        0xF4AF, 0xCF9F, 0x82CF, 0xB9FF, 0x186F, 0x235F, 0x6E0F, 0x553F,
+        0x104A, 0x2B7A, 0x662A, 0x5D1A, 0xFC8A, 0xC7BA, 0x8AEA, 0xB1DA,
+        0xD43B, 0xEF0B, 0xA25B, 0x996B, 0x38FB, 0x03CB, 0x4E9B, 0x75AB,
+        0x30DE, 0x0BEE, 0x46BE, 0x7D8E, 0xDC1E, 0xE72E, 0xAA7E, 0x914E,
+        0x2094, 0x1BA4, 0x56F4, 0x6DC4, 0xCC54, 0xF764, 0xBA34, 0x8104,
+        0xC471, 0xFF41, 0xB211, 0x8921, 0x28B1, 0x1381, 0x5ED1, 0x65E1,
+        0x9513, 0xAE23, 0xE373, 0xD843, 0x79D3, 0x42E3, 0x0FB3, 0x3483,
+        0x71F6, 0x4AC6, 0x0796, 0x3CA6, 0x9D36, 0xA606, 0xEB56, 0xD066,
+        0x61BC, 0x5A8C, 0x17DC, 0x2CEC, 0x8D7C, 0xB64C, 0xFB1C, 0xC02C,
+        0x8559, 0xBE69, 0xF339, 0xC809, 0x6999, 0x52A9, 0x1FF9, 0x24C9,
+        0x4128, 0x7A18, 0x3748, 0x0C78, 0xADE8, 0x96D8, 0xDB88, 0xE0B8,
+        0xA5CD, 0x9EFD, 0xD3AD, 0xE89D, 0x490D, 0x723D, 0x3F6D, 0x045D,
+        0xB587, 0x8EB7, 0xC3E7, 0xF8D7, 0x5947, 0x6277, 0x2F27, 0x1417,
+        0x5162, 0x6A52, 0x2702, 0x1C32, 0xBDA2, 0x8692, 0xCBC2, 0xF0F2,
+        0x1743, 0x2C73, 0x6123, 0x5A13, 0xFB83, 0xC0B3, 0x8DE3, 0xB6D3,
+        0xF3A6, 0xC896, 0x85C6, 0xBEF6, 0x1F66, 0x2456, 0x6906, 0x5236,
+        0xE3EC, 0xD8DC, 0x958C, 0xAEBC, 0x0F2C, 0x341C, 0x794C, 0x427C,
+        0x0709, 0x3C39, 0x7169, 0x4A59, 0xEBC9, 0xD0F9, 0x9DA9, 0xA699,
+        0xC378, 0xF848, 0xB518, 0x8E28, 0x2FB8, 0x1488, 0x59D8, 0x62E8,
+        0x279D, 0x1CAD, 0x51FD, 0x6ACD, 0xCB5D, 0xF06D, 0xBD3D, 0x860D,
+        0x37D7, 0x0CE7, 0x41B7, 0x7A87, 0xDB17, 0xE027, 0xAD77, 0x9647,
+        0xD332, 0xE802, 0xA552, 0x9E62, 0x3FF2, 0x04C2, 0x4992, 0x72A2,
+        0x8250, 0xB960, 0xF430, 0xCF00, 0x6E90, 0x55A0, 0x18F0, 0x23C0,
+        0x66B5, 0x5D85, 0x10D5, 0x2BE5, 0x8A75, 0xB145, 0xFC15, 0xC725,
+        0x76FF, 0x4DCF, 0x009F, 0x3BAF, 0x9A3F, 0xA10F, 0xEC5F, 0xD76F,
+        0x921A, 0xA92A, 0xE47A, 0xDF4A, 0x7EDA, 0x45EA, 0x08BA, 0x338A,
+        0x566B, 0x6D5B, 0x200B, 0x1B3B, 0xBAAB, 0x819B, 0xCCCB, 0xF7FB,
+        0xB28E, 0x89BE, 0xC4EE, 0xFFDE, 0x5E4E, 0x657E, 0x282E, 0x131E,
+        0xA2C4, 0x99F4, 0xD4A4, 0xEF94, 0x4E04, 0x7534, 0x3864, 0x0354,
+        0x4621, 0x7D11, 0x3041, 0x0B71, 0xAAE1, 0x91D1, 0xDC81, 0xE7B1
+    }
+    #endif
+};
+
+/**
+ * @brief               Calculates the EN 13757 CRC-16 of a buffer
+ * @param data          Binary data
+ * @param len           Length of the binary data
+ * @return              CRC value
+ * @protected
+ */
+uint16_t AllWize::_crc16(const uint8_t * data, uint8_t len) {
+
+    uint16_t crc = 0x0000;
+
+    #if CRC_SLICE_BY == 4
+        while (len >= 4) {
+            crc = pgm_read_word(&CRC_TABLE[3][data[0] ^ (crc >> 8)])
+                ^ pgm_read_word(&CRC_TABLE[2][data[1] ^ (crc & 0xFF)])
+                ^ pgm_read_word(&CRC_TABLE[1][data[2]])
+                ^ pgm_read_word(&CRC_TABLE[0][data[3]]);
+            data += 4;
+            len -= 4;
+        }
+    #endif
+
+    while (len--) {
+        crc = (crc << 8) ^ pgm_read_word(&CRC_TABLE[0][(crc >> 8) ^ *data++]);
+    }
+
+    return crc ^ 0xFFFF;
 
 }
 
@@ -1763,15 +3484,15 @@ uint8_t AllWize::_send(uint8_t *buffer, uint8_t len) {
 
 /**
  * @brief               Listens to incoming data from the module until timeout or END_OF_RESPONSE.
- * @return              Number of bytes received and stored in the internal _buffer.
+ * @return              Number of bytes received and stored in the internal _response buffer.
  * @protected
  */
 int8_t AllWize::_receive() {
-    return _readBytesUntil(END_OF_RESPONSE, (char *) _buffer, RX_BUFFER_SIZE);
+    return _readBytesUntil(END_OF_RESPONSE, (char *) _response, COMMAND_RESPONSE_SIZE);
 }
 
 /**
- * @brief               Sends a binary buffer and waits for response. Returns the number of bytes received and stored in the internal _buffer.
+ * @brief               Sends a binary buffer and waits for response. Returns the number of bytes received and stored in the internal _response buffer.
  * @param buffer        Binary data to send
  * @param len           Length of the binary data
  * @return              Number of bytes received, -1 if timed out or error sending
@@ -1783,7 +3504,7 @@ int8_t AllWize::_sendAndReceive(uint8_t *buffer, uint8_t len) {
 }
 
 /**
- * @brief               Sends a byte and waits for response. Returns the number of bytes received and stored in the internal _buffer.
+ * @brief               Sends a byte and waits for response. Returns the number of bytes received and stored in the internal _response buffer.
  * @param ch            Byte to send (-1 if timed out)
  * @return              Number of bytes received, -1 if timed out or error sending
  * @protected
@@ -1835,19 +3556,7 @@ int AllWize::_timedRead() {
  * @protected
  */
 int AllWize::_readBytes(char * data, uint16_t len) {
-    
-    if (len < 1) return 0;
-    
-    uint16_t index = 0;
-    while (index < len) {
-        int ch = _timedRead();
-        if (ch < 0) return -1;
-        *data++ = (char)ch;
-        index++;
-    }
-    
-    return index;
-
+    return _readStream(data, len, -1);
 }
 
 /**
@@ -1859,18 +3568,50 @@ int AllWize::_readBytes(char * data, uint16_t len) {
  * @protected
  */
 int AllWize::_readBytesUntil(char terminator, char *data, uint16_t len) {
-    
+    return _readStream(data, len, (uint8_t) terminator);
+}
+
+/**
+ * @brief               Reads the stream buffer up to a number of bytes or a certain char.
+ *                      Uses a single deadline for the whole read and drains all available bytes at once.
+ *                      Fixed length reads add the time it takes to transmit len bytes to the timeout,
+ *                      reads up to a terminator only wait for the timeout since len is just a maximum.
+ * @param data          Buffer to store the values to
+ * @param len           Max number of bytes to read
+ * @param terminator    Terminating char, -1 for none
+ * @return              Number of bytes read or -1 if timed out
+ * @protected
+ */
+int AllWize::_readStream(char * data, uint16_t len, int terminator) {
+
     if (len < 1) return 0;
-    
+
+    uint32_t start_us = micros();
+    uint32_t start = millis();
+    uint32_t deadline = _timeout;
+    if (terminator < 0) deadline += (uint32_t) len * 10000 / _baudrate + 1;
     uint16_t index = 0;
+
     while (index < len) {
-        int ch = _timedRead();
-        if (ch < 0) return -1;
-        if (ch == terminator) break;
-        *data++ = (char) ch;
-        index++;
+
+        if (_stream->available() > 0) {
+            int ch = _stream->read();
+            if (ch < 0) continue;
+            if (ch == terminator) break;
+            *data++ = (char) ch;
+            index++;
+            continue;
+        }
+
+        if (millis() - start > deadline) return -1;
+        yield();
+
     }
-    
+
+    // Throughput stats
+    _read_bytes += index;
+    _read_us += (micros() - start_us);
+
     return index;
 
 }
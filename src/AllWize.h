@@ -42,30 +42,277 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // General
 #define MODEM_DEFAULT_BAUDRATE          BAUDRATE_19200
 #define GPIO_NONE                       0x99
-#define RX_BUFFER_SIZE                  255
 #define DEFAULT_TIMEOUT                 100
 #define HARDWARE_SERIAL_PORT            1
 #define DEFAULT_MBUS_MODE               MBUS_MODE_N1
+#define RX_FRAME_TIMEOUT                100
+#define RX_STALL_TIMEOUT                60000
+#define BAUDRATE_PROBE_TIMEOUT          500
+#define RESET_TIMEOUT                   1000
+#define RESET_PROBE_TIMEOUT             10
+#define RESET_PROBE_INTERVAL            5
+#define RESET_GUARD_TIME                10
+
+// Highest UART baudrate (BAUDRATE_*) begin() will try to switch the module to, 0 to disable
+// SoftwareSerial is not reliable above BAUDRATE_57600
+#ifndef MODEM_UPGRADE_BAUDRATE
+#define MODEM_UPGRADE_BAUDRATE          0
+#endif
+
+// Memory budget profiles, MEMORY_PROFILE sizes the receive buffer, the receive queue
+// and the memory cache for the board. Each of them can still be overridden on its own.
+// The size of an AllWize instance, receive queue and optional caches included, is checked
+// against MEMORY_PROFILE_BUDGET, the profile ceiling (MEMORY_PROFILE_RAM) unless overridden.
+// The tiny profile receive buffer holds 64 bytes, longer frames (more than 61 bytes after
+// the length byte with start and stop bytes) are dropped and counted, see getOversizedFrames.
+#define MEMORY_PROFILE_TINY             1   // 8-bit AVR nodes (Uno, Leonardo)
+#define MEMORY_PROFILE_STANDARD         2
+#define MEMORY_PROFILE_GATEWAY          3   // ESP8266, ESP32 gateways
+
+// Memory cache policies (USE_MEMORY_CACHE)
+#define MEMORY_CACHE_NONE               0   // Every read goes to the module
+#define MEMORY_CACHE_FULL               1   // Mirror of the whole module memory, filled in pages
+#define MEMORY_CACHE_SLOTS              2   // Only the slots the library reads itself
+
+#ifndef MEMORY_PROFILE
+#define MEMORY_PROFILE                  MEMORY_PROFILE_STANDARD
+#endif
+
+#if MEMORY_PROFILE == MEMORY_PROFILE_TINY
+    #define MEMORY_PROFILE_RX_BUFFER    64
+    #define MEMORY_PROFILE_RX_QUEUE     1
+    #define MEMORY_PROFILE_IN_PLACE     1
+    #define MEMORY_PROFILE_CACHE        MEMORY_CACHE_SLOTS
+    #define MEMORY_PROFILE_RAM          384
+#elif MEMORY_PROFILE == MEMORY_PROFILE_GATEWAY
+    #define MEMORY_PROFILE_RX_BUFFER    255
+    #define MEMORY_PROFILE_RX_QUEUE     8
+    #define MEMORY_PROFILE_IN_PLACE     0
+    #define MEMORY_PROFILE_CACHE        MEMORY_CACHE_FULL
+    #define MEMORY_PROFILE_RAM          4096
+#elif MEMORY_PROFILE == MEMORY_PROFILE_STANDARD
+    #define MEMORY_PROFILE_RX_BUFFER    255
+    #define MEMORY_PROFILE_RX_QUEUE     1
+    #define MEMORY_PROFILE_IN_PLACE     0
+    #define MEMORY_PROFILE_CACHE        MEMORY_CACHE_FULL
+    #define MEMORY_PROFILE_RAM          1280
+#else
+    #error "Unknown MEMORY_PROFILE"
+#endif
+
+// Max frame length that can be received (up to 255)
+#ifndef RX_BUFFER_SIZE
+#define RX_BUFFER_SIZE                  MEMORY_PROFILE_RX_BUFFER
+#endif
 
+
+// Number of received messages that can be queued waiting to be read
+#ifndef RX_QUEUE_SIZE
+#define RX_QUEUE_SIZE                   MEMORY_PROFILE_RX_QUEUE
+#endif
+
+// Decode messages in place, the payload of a received message points to the raw
+// frame in the receive buffer instead of being copied (saves RX_BUFFER_SIZE bytes).
+// The payload is only valid until the next frame is received or a command is run
+// and new frames are left in the stream until the current message has been read.
+#ifndef RX_DECODE_IN_PLACE
+#define RX_DECODE_IN_PLACE              MEMORY_PROFILE_IN_PLACE
+#endif
+
+#if RX_DECODE_IN_PLACE && (RX_QUEUE_SIZE != 1)
+#error "RX_DECODE_IN_PLACE requires RX_QUEUE_SIZE to be 1"
+#endif
+
+// What to do when a message arrives and the queue is full
+#define RX_QUEUE_DROP_OLDEST            0
+#define RX_QUEUE_DROP_NEWEST            1
+
+// CRC-16 implementation: 1 for byte-wise (512 bytes table),
+// 4 for slice-by-4 (2048 bytes tables, faster on 32-bit platforms)
+#ifndef CRC_SLICE_BY
+#define CRC_SLICE_BY                    1
+#endif
+
+// Drop messages with a wrong CRC (when using DATA_INTERFACE_CRC*),
+// otherwise they are delivered with crc_ok set to false
+#ifndef CRC_DROP_INVALID
+#define CRC_DROP_INVALID                1
+#endif
+
+// Number of buckets of the first byte to read() latency histogram (0 to disable)
+// Bucket 0 counts latencies under 1ms, bucket N latencies from 2^(N-1) to 2^N ms
+// and the last one also everything above
+#ifndef RX_LATENCY_BUCKETS
+#define RX_LATENCY_BUCKETS              0
+#endif
+
+// Number of entries in the duplicate message cache (0 to disable)
+// Wize messages are identified by manufacturer, address and wize counter
+#ifndef DEDUP_CACHE_SIZE
+#define DEDUP_CACHE_SIZE                0
+#endif
+#define DEDUP_PROBES                    4
+#define DEDUP_WINDOW                    10000
+
+// Drop duplicate messages, otherwise they are delivered with duplicate set to true
+#ifndef DEDUP_DROP
+#define DEDUP_DROP                      1
+#endif
+
+// Size in bits of the device address Bloom filter (0 to disable)
+#ifndef FILTER_BLOOM_BITS
+#define FILTER_BLOOM_BITS               0
+#endif
+#define FILTER_BLOOM_HASHES             3
+
+// Memory cache policy, one of MEMORY_CACHE_*
 #ifndef USE_MEMORY_CACHE
-#define USE_MEMORY_CACHE                1
+#define USE_MEMORY_CACHE                MEMORY_PROFILE_CACHE
 #endif
+#define MEMORY_PAGE_SIZE                16
+#define MEMORY_DUMP_PAGES               4
+#define MEMORY_CACHE_SLOT_COUNT         7
+
+// Max length of the fields in the module signature
+#define MODEL_PART_NUMBER_SIZE          16
+#define MODEL_VERSION_SIZE              8
+
+// Receive state machine
+enum {
+    RX_STATE_START,
+    RX_STATE_LENGTH,
+    RX_STATE_DATA,
+    RX_STATE_SKIP
+};
+
+// Command state machine
+enum {
+    COMMAND_STATE_IDLE,
+    COMMAND_STATE_ENTER,
+    COMMAND_STATE_PROMPT,
+    COMMAND_STATE_RESPONSE,
+    COMMAND_STATE_EXIT
+};
+
+// Max data length for asynchronous commands (the key register command is the longest)
+#define COMMAND_ASYNC_SIZE              17
+
+// Max command response length kept, module responses are a single byte
+#define COMMAND_RESPONSE_SIZE           4
 
+// Header of a received message, fields ordered by size so it has no padding
 typedef struct {
+    uint32_t first_byte_us;
+    uint32_t last_byte_us;
+    uint16_t wize_counter;
+    char man[4];
+    uint8_t address[4];
     uint8_t c;
     uint8_t ci;
-    char man[4];
     uint8_t type;
     uint8_t version;
-    uint8_t address[4];
     uint8_t len;
-    uint8_t data[RX_BUFFER_SIZE];
     uint8_t rssi;
+    bool crc_ok;
+    bool duplicate;
     uint8_t wize_control;
     uint8_t wize_network_id;
-    uint16_t wize_counter;
     uint8_t wize_application;
-} allwize_message_t;
+} allwize_header_t;
+
+// Received message, header followed by the payload storage
+// Copies only move the header and the len bytes of payload in use
+struct allwize_packet_t : public allwize_header_t {
+
+    #if RX_DECODE_IN_PLACE
+
+    uint8_t * data = NULL;
+
+    #else
+
+    uint8_t data[RX_BUFFER_SIZE];
+
+    allwize_packet_t() {
+        len = 0;
+        data[0] = 0;
+    }
+
+    allwize_packet_t(const allwize_packet_t & other) {
+        *this = other;
+    }
+
+    allwize_packet_t & operator=(const allwize_packet_t & other) {
+        if (this == &other) return *this;
+        *static_cast<allwize_header_t *>(this) = other;
+        if (len >= RX_BUFFER_SIZE) len = RX_BUFFER_SIZE - 1;
+        memcpy(data, other.data, len);
+        data[len] = 0;
+        return *this;
+    }
+
+    #endif
+
+};
+
+// Compatibility alias, the fields are the same as in previous versions
+typedef allwize_packet_t allwize_message_t;
+
+// Lightweight view of a received message, data points to the library
+// receive storage and is only valid until the next call to available()
+struct allwize_view_t : public allwize_header_t {
+    const uint8_t * data;
+};
+
+// Configuration profile, see AllWize::applyProfile
+// Fields set to PROFILE_KEEP (or a NULL key) are left untouched
+#define PROFILE_KEEP                    0xFF
+typedef struct {
+    uint8_t network_role;
+    uint8_t channel;
+    uint8_t power;
+    uint8_t data_rate;
+    uint8_t mbus_mode;
+    uint8_t data_interface;
+    uint8_t append_rssi;
+    const uint8_t * default_key;
+} allwize_profile_t;
+
+// Flags returned by AllWize::applyProfile
+#define PROFILE_NETWORK_ROLE            0x0001
+#define PROFILE_CHANNEL                 0x0002
+#define PROFILE_POWER                   0x0004
+#define PROFILE_DATA_RATE               0x0008
+#define PROFILE_MBUS_MODE               0x0010
+#define PROFILE_DATA_INTERFACE          0x0020
+#define PROFILE_APPEND_RSSI             0x0040
+#define PROFILE_DEFAULT_KEY             0x0080
+#define PROFILE_ERROR                   0x8000
+
+// Module configuration fingerprint to speed up warm starts
+typedef struct {
+    uint8_t module;
+    uint8_t mbus_mode;
+    uint8_t data_interface;
+    uint8_t append_rssi;
+    uint8_t baudrate;
+    uint16_t checksum;
+} allwize_fingerprint_t;
+
+// Duplicate message cache entry
+typedef struct {
+    bool used;
+    uint16_t man;
+    uint16_t counter;
+    uint32_t address;
+    uint32_t when;
+} allwize_dedup_t;
+
+// Callback for new messages, see AllWize::onMessage
+typedef void (*allwize_callback_t)(const allwize_view_t & message, void * ctx);
+
+// Callback for asynchronous commands, see AllWize::commandAsync
+// result is the number of bytes in the response or -1 if the command failed
+typedef void (*allwize_command_callback_t)(int8_t result, const uint8_t * response, void * ctx);
 
 // -----------------------------------------------------------------------------
 // DEBUG
@@ -99,21 +346,57 @@ class AllWize {
         AllWize(uint8_t rx, uint8_t tx, uint8_t reset_gpio = GPIO_NONE, uint8_t config_gpio = GPIO_NONE);
 
         void begin(uint8_t baudrate = MODEM_DEFAULT_BAUDRATE);
+        bool begin(const allwize_fingerprint_t & fingerprint, uint8_t baudrate = MODEM_DEFAULT_BAUDRATE);
+        bool getFingerprint(allwize_fingerprint_t & fingerprint);
         bool reset();
         void softReset();
         bool factoryReset();
+        uint32_t getResetTime();
         void sleep();
         void wakeup();
         bool ready();
         bool waitForReady(uint32_t timeout = DEFAULT_TIMEOUT);
         void dump(Stream & debug);
 
+        bool beginConfig();
+        bool commitConfig();
+        bool flushMemory();
+
         bool ack();
         bool send(uint8_t * buffer, uint8_t len);
         bool send(const char * buffer);
         bool available();
+        uint8_t pump();
+        void onMessage(allwize_callback_t callback, void * ctx = NULL);
+        bool commandAsync(uint8_t command, const uint8_t * data = NULL, uint8_t len = 0, allwize_command_callback_t callback = NULL, void * ctx = NULL);
+        bool poll();
         bool enableRX(bool enable);
+        void setContinuousRX(bool enable, uint32_t stall_timeout = RX_STALL_TIMEOUT);
+        bool getContinuousRX();
         allwize_message_t read();
+        bool read(allwize_view_t & view);
+        size_t readMany(allwize_message_t * out, size_t max);
+        size_t readMany(allwize_view_t * out, size_t max);
+        void setQueuePolicy(uint8_t policy);
+        uint8_t getQueueCount();
+        uint32_t getQueueOverflows();
+        uint32_t getCRCErrors();
+        uint32_t getOversizedFrames();
+        void setFilter(const uint32_t * addresses, uint16_t count);
+        #if FILTER_BLOOM_BITS > 0
+        void addBloomFilter(uint32_t address);
+        void clearBloomFilter();
+        #endif
+        uint32_t getFilterHits();
+        uint32_t getFilterMisses();
+        #if DEDUP_CACHE_SIZE > 0
+        void setDuplicateWindow(uint32_t ms);
+        uint32_t getDuplicates();
+        #endif
+        #if RX_LATENCY_BUCKETS > 0
+        uint32_t getLatencyHistogram(uint8_t bucket);
+        void resetLatencyHistogram();
+        #endif
         uint8_t * getBuffer();
         uint8_t getLength();
 
@@ -123,6 +406,7 @@ class AllWize {
         void master();
         void slave();
         void repeater();
+        uint16_t applyProfile(const allwize_profile_t & profile);
 
         void setChannel(uint8_t channel, bool persist = false);
         void setPower(uint8_t power, bool persist = false);
@@ -144,6 +428,7 @@ class AllWize {
         void setDefaultKey(const uint8_t * key);
         void setAccessNumber(uint8_t value);
         void setBaudRate(uint8_t baudrate);
+        uint8_t negotiateBaudRate(uint8_t max);
 
         uint8_t getChannel();
         uint8_t getPower();
@@ -164,26 +449,34 @@ class AllWize {
         void getDefaultKey(uint8_t * key);
         uint8_t getBaudRate();
         uint32_t getBaudRateSpeed(uint8_t value);
+        uint32_t getReadRate();
 
         float getRSSI();
         uint8_t getTemperature();
         uint16_t getVoltage();
         String getMID();
+        bool getMID(char * buffer, size_t size);
         bool setMID(uint16_t mid);
         String getUID();
+        bool getUID(char * buffer, size_t size);
         bool setUID(uint32_t uid);
         uint8_t getVersion();
         void setVersion(uint8_t version);
         uint8_t getDevice();
         void setDevice(uint8_t type);
         String getPartNumber();
+        bool getPartNumber(char * buffer, size_t size);
         String getRequiredHardwareVersion();
+        bool getRequiredHardwareVersion(char * buffer, size_t size);
         String getFirmwareVersion();
+        bool getFirmwareVersion(char * buffer, size_t size);
         String getSerialNumber();
+        bool getSerialNumber(char * buffer, size_t size);
         double getFrequency(uint8_t channel);
         uint16_t getDataRateSpeed(uint8_t dr);
         uint8_t getModuleType();
         String getModuleTypeName();
+        bool getModuleTypeName(char * buffer, size_t size);
 
         // Wize specific
         bool setWizeControl(uint8_t wize_control);
@@ -202,25 +495,63 @@ class AllWize {
         int8_t _sendCommand(uint8_t command, uint8_t * data, uint8_t len);
         int8_t _sendCommand(uint8_t command, uint8_t data);
         int8_t _sendCommand(uint8_t command);
+        bool _commandStart(uint8_t command, const uint8_t * data, uint8_t len, allwize_command_callback_t callback, void * ctx);
+        void _commandExit();
+        void _commandDone();
 
         bool _cacheMemory(uint8_t * buffer);
+        uint8_t _readMemory(uint8_t address, uint8_t * buffer, uint8_t len);
+        #if USE_MEMORY_CACHE == MEMORY_CACHE_FULL
+        bool _fetchMemory(uint8_t address, uint16_t len);
+        #elif USE_MEMORY_CACHE == MEMORY_CACHE_SLOTS
+        int8_t _slotCacheIndex(uint8_t slot);
+        #endif
         uint8_t _getMemory(uint8_t address);
         uint8_t _getMemory(uint8_t address, uint8_t *buffer, uint8_t len);
         bool _setMemory(uint8_t address, uint8_t data);
         bool _setMemory(uint8_t address, uint8_t * data, uint8_t len);
 
         bool _setSlot(uint8_t slot, uint8_t data);
+        bool _setSlotAt(uint8_t slot, uint8_t address, uint8_t data);
         bool _setSlot(uint8_t slot, uint8_t * data, uint8_t len);
         uint8_t _getSlot(uint8_t slot);
+        uint8_t _getSlotAt(uint8_t slot, uint8_t address);
         uint8_t _getSlot(uint8_t slot, uint8_t * buffer, uint8_t len);
         String _getSlotAsHexString(uint8_t slot, uint8_t len);
+        bool _getSlotAsHexString(uint8_t slot, uint8_t len, char * buffer, size_t size);
         String _getSlotAsString(uint8_t slot, uint8_t len);
 
         void _readModel();
+        bool _warmStart(const allwize_fingerprint_t & fingerprint);
+        uint8_t _dataRateValue(uint8_t dr);
+        bool _modeAllowed(uint8_t mode);
+        void _parseModel(const char * signature);
+        bool _resetModule();
+        uint8_t _getBaudRateCode();
+        bool _sendReset(uint8_t type);
+        bool _waitForReset(uint32_t timeout);
+        void _upgradeBaudRate(bool before);
+        bool _tryBaudRate(uint8_t value);
+        uint8_t _probeBaudRate(uint8_t from, uint8_t to);
+        bool _copyString(const char * value, char * buffer, size_t size);
+        bool _parse(uint8_t ch);
         bool _decode();
+        virtual void _postDecode(allwize_message_t * message);
+        uint8_t _pump(bool stop_when_full = false);
+        void _dispatch();
+        uint16_t _crc16(const uint8_t * data, uint8_t len);
+        bool _filter(uint32_t address);
+        #if DEDUP_CACHE_SIZE > 0
+        uint8_t _dedupIndex(uint16_t man, uint32_t address, uint16_t counter);
+        bool _duplicate(uint16_t man, uint32_t address, uint16_t counter);
+        void _dedupRecord(uint16_t man, uint32_t address, uint16_t counter);
+        #endif
+        allwize_message_t * _queuePush();
+        allwize_message_t * _queuePop();
+        void _view(const allwize_message_t * message, allwize_view_t & view);
 
         void _flush();
-        void _resetSerial();
+        virtual void _resetSerial();
         uint8_t _send(uint8_t * buffer, uint8_t len);
         uint8_t _send(uint8_t ch);
         int8_t _receive();
@@ -230,6 +561,7 @@ class AllWize {
         int _timedRead();
         int _readBytes(char * buffer, uint16_t len);
         int _readBytesUntil(char terminator, char * buffer, uint16_t len);
+        int _readStream(char * buffer, uint16_t len, int terminator);
         void _hex2bin(char * hex, uint8_t * bin, uint8_t len);
         void _bin2hex(uint8_t * bin, char * hex, uint8_t len);
 
@@ -257,8 +589,13 @@ class AllWize {
         uint8_t _reset_gpio = GPIO_NONE;
         uint8_t _config_gpio = GPIO_NONE;
         bool _config = false;
+        uint8_t _config_depth = 0;
+        uint8_t _config_errors = 0;
         uint32_t _timeout = DEFAULT_TIMEOUT;
+        uint32_t _reset_time = 0;
         uint32_t _baudrate = 19200;
+        uint32_t _read_bytes = 0;
+        uint32_t _read_us = 0;
         
         uint8_t _ci = CI_APP_RESPONSE_UP_SHORT;
         uint8_t _mbus_mode = 0xFF;
@@ -268,14 +605,18 @@ class AllWize {
         uint8_t _module = MODULE_UNKNOWN;
 
         // Memory buffer
-        #if USE_MEMORY_CACHE
-            bool _ready = false;
+        #if USE_MEMORY_CACHE == MEMORY_CACHE_FULL
+            uint16_t _memory_valid = 0;
             uint8_t _memory[0x100] = {0xFF};
+            uint8_t _memory_dirty[0x100 / 8] = {0};
+        #elif USE_MEMORY_CACHE == MEMORY_CACHE_SLOTS
+            uint8_t _slot_valid = 0;
+            uint8_t _slot_cache[MEMORY_CACHE_SLOT_COUNT] = {0};
         #endif
 
-        String _model;
-        String _hw;
-        String _fw;
+        char _model[MODEL_PART_NUMBER_SIZE + 1] = {0};
+        char _hw[MODEL_VERSION_SIZE + 1] = {0};
+        char _fw[MODEL_VERSION_SIZE + 1] = {0};
 
         // Wize specific
         uint8_t _wize_control = 0x40;
@@ -283,12 +624,69 @@ class AllWize {
         uint8_t _wize_application = 0xFE;
         uint16_t _counter = 0;
 
-        // Message buffers
-        allwize_message_t _message;
-        uint8_t _buffer[RX_BUFFER_SIZE];
+        // Receive queue
+        allwize_message_t _queue[RX_QUEUE_SIZE];
+        uint8_t _queue_head = 0;
+        uint8_t _queue_tail = 0;
+        uint8_t _queue_count = 0;
+        uint8_t _queue_policy = RX_QUEUE_DROP_OLDEST;
+        uint32_t _queue_overflows = 0;
+        uint32_t _crc_errors = 0;
+        uint32_t _oversized_frames = 0;
+        const uint32_t * _filter_addresses = NULL;
+        uint16_t _filter_count = 0;
+        #if FILTER_BLOOM_BITS > 0
+        uint8_t _filter_bloom[(FILTER_BLOOM_BITS + 7) / 8] = {0};
+        bool _filter_bloom_enabled = false;
+        #endif
+        uint32_t _filter_hits = 0;
+        uint32_t _filter_misses = 0;
+        #if DEDUP_CACHE_SIZE > 0
+        allwize_dedup_t _dedup[DEDUP_CACHE_SIZE] = {};
+        uint32_t _dedup_window = DEDUP_WINDOW;
+        uint32_t _duplicates = 0;
+        #endif
+        #if RX_LATENCY_BUCKETS > 0
+        uint32_t _latency[RX_LATENCY_BUCKETS] = {0};
+        #endif
+
+        // Command state
+        uint8_t _cmd_state = COMMAND_STATE_IDLE;
+        uint8_t _cmd_command = 0;
+        const uint8_t * _cmd_data = NULL;
+        uint8_t _cmd_len = 0;
+        uint8_t _cmd_copy[COMMAND_ASYNC_SIZE];
+        uint8_t _response[COMMAND_RESPONSE_SIZE];
+        uint8_t _cmd_count = 0;
+        int8_t _cmd_result = -1;
+        uint32_t _cmd_last = 0;
+        allwize_command_callback_t _cmd_callback = NULL;
+        void * _cmd_callback_ctx = NULL;
+
+        // Message callback
+        allwize_callback_t _callback = NULL;
+        void * _callback_ctx = NULL;
+
+        // Message buffers (one extra byte for the payload terminator when decoding in place)
+        uint8_t _buffer[RX_BUFFER_SIZE + 1];
         uint8_t _pointer = 0;
         uint8_t _length = 0;
+        uint8_t _rx_state = RX_STATE_START;
+        uint16_t _rx_expected = 0;
+        uint32_t _rx_last = 0;
+        uint32_t _rx_first_us = 0;
+        uint32_t _rx_last_us = 0;
+        bool _continuous_rx = false;
+        bool _rx_reset_pending = false;
+        uint32_t _rx_stall_timeout = RX_STALL_TIMEOUT;
 
 };
 
+// Max size in bytes of an AllWize instance
+#ifndef MEMORY_PROFILE_BUDGET
+#define MEMORY_PROFILE_BUDGET           MEMORY_PROFILE_RAM
+#endif
+
+static_assert(sizeof(AllWize) <= MEMORY_PROFILE_BUDGET, "AllWize instance does not fit in the MEMORY_PROFILE budget, shrink the queue and caches or raise MEMORY_PROFILE_BUDGET");
+
 #endif // ALLWIZE_H
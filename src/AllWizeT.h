@@ -0,0 +1,163 @@
+/*
+
+AllWize Library
+
+Copyright (C) 2018-2021 by AllWize <github@allwize.io>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/**
+ * @file AllWizeT.h
+ * AllWize library front end for firmwares built for a single module type
+ */
+
+#ifndef ALLWIZE_T_H
+#define ALLWIZE_T_H
+
+#include "AllWize.h"
+
+/**
+ * AllWize variant for a module type known at compile time (MODULE_MBUS4, MODULE_OSP or MODULE_WIZE).
+ * The module model is not read on begin, and memory addresses and module specific
+ * checks in the methods below are resolved by the compiler. They are not virtual, calls
+ * through an AllWize pointer or reference use the AllWize versions. The rest of the library
+ * (send, decode, applyProfile, master, slave,...) checks the module type at runtime as AllWize does.
+ */
+template <uint8_t MODULE>
+class AllWizeT: public AllWize {
+
+    static_assert((MODULE_UNKNOWN < MODULE) && (MODULE < MODULE_MAX), "Unknown module type");
+
+    public:
+
+        AllWizeT(HardwareSerial * serial, uint8_t reset_gpio = GPIO_NONE, uint8_t config_gpio = GPIO_NONE): AllWize(serial, reset_gpio, config_gpio) { _setModule(); }
+        #if not defined(ARDUINO_ARCH_SAMD) && not defined(ARDUINO_ARCH_ESP32)
+        AllWizeT(SoftwareSerial * serial, uint8_t reset_gpio = GPIO_NONE, uint8_t config_gpio = GPIO_NONE): AllWize(serial, reset_gpio, config_gpio) { _setModule(); }
+        #endif
+        AllWizeT(uint8_t rx, uint8_t tx, uint8_t reset_gpio = GPIO_NONE, uint8_t config_gpio = GPIO_NONE): AllWize(rx, tx, reset_gpio, config_gpio) { _setModule(); }
+
+        /**
+         * @brief               Inits the module communications without querying the module model
+         * @param baudrate      Baudrate
+         */
+        void begin(uint8_t baudrate = MODEM_DEFAULT_BAUDRATE) {
+            _baudrate = BAUDRATES[baudrate-1];
+            _upgradeBaudRate(true);
+            reset();
+            _setModule();
+            _append_rssi = _getSlotAt(MEM_RSSI_MODE, _address(MEM_RSSI_MODE)) == 0x01;
+            _mbus_mode = _getSlotAt(MEM_MBUS_MODE, _address(MEM_MBUS_MODE));
+            _data_interface = _getSlotAt(MEM_DATA_INTERFACE, _address(MEM_DATA_INTERFACE));
+            _upgradeBaudRate(false);
+        }
+
+        /**
+         * @brief               Inits the module communications trusting a fingerprint saved by the
+         *                      application, see AllWize::begin. Fingerprints for other module types
+         *                      are not valid.
+         * @param fingerprint   Fingerprint as returned by getFingerprint
+         * @param baudrate      Baudrate used if the fingerprint is not valid
+         * @return              True if the fingerprint has been used
+         */
+        bool begin(const allwize_fingerprint_t & fingerprint, uint8_t baudrate = MODEM_DEFAULT_BAUDRATE) {
+            bool valid = (MODULE == fingerprint.module) && _warmStart(fingerprint);
+            if (!valid) begin(baudrate);
+            return valid;
+        }
+
+        /**
+         * @brief               Sets the communications channel (for MBUS_MODE_R2 only)
+         * @param channel       Channel number
+         * @param persist       Persist the changes in non-volatile memory (defaults to False)
+         */
+        void setChannel(uint8_t channel, bool persist = false) {
+            if (channel > 41) return;
+            if (persist) {
+                _setSlotAt(MEM_CHANNEL, _address(MEM_CHANNEL), channel);
+                if (MODULE_WIZE == MODULE) {
+                    _setSlotAt(MEM_CHANNEL_RX, _address(MEM_CHANNEL_RX), channel);
+                }
+            }
+            _sendCommand(CMD_CHANNEL, channel);
+        }
+
+        /**
+         * @brief               Sets the data rate
+         * @param dr            Value in [1, 2, 3, 4, 5]
+         */
+        void setDataRate(uint8_t dr) {
+            if (MODULE_MBUS4 == MODULE) return;
+            if (dr < 1) return;
+            if (MODULE_OSP == MODULE) {
+                if (DATARATE_6400bps == dr) dr = DATARATE_6400bps_OSP;
+                if (dr > 5) return;
+            }
+            if (MODULE_WIZE == MODULE) {
+                if (dr > 3) return;
+                _setSlotAt(MEM_DATA_RATE_RX, _address(MEM_DATA_RATE_RX), dr);
+            }
+            _setSlotAt(MEM_DATA_RATE, _address(MEM_DATA_RATE), dr);
+        }
+
+        /**
+         * @brief               Sets the module in one of the available MBus modes
+         * @param mode          MBus mode (MBUS_MODE_*)
+         * @param persist       Persist the changes in non-volatile memory (defaults to False)
+         */
+        void setMode(uint8_t mode, bool persist = false) {
+            if (MODULE_WIZE == MODULE) {
+                if ((MBUS_MODE_N1 != mode) && (MBUS_MODE_N2 != mode)) return;
+            }
+            if ((MODULE_OSP != MODULE) && (MBUS_MODE_OSP == mode)) return;
+            if (persist) {
+                _setSlotAt(MEM_MBUS_MODE, _address(MEM_MBUS_MODE), mode);
+            }
+            _sendCommand(CMD_MBUS_MODE, mode);
+            _mbus_mode = mode;
+        }
+
+        /**
+         * @brief               Returns the module type
+         * @return              Module type this class was built for
+         */
+        uint8_t getModuleType() {
+            return MODULE;
+        }
+
+    protected:
+
+        /**
+         * @brief               Sets the module type and its defaults
+         * @protected
+         */
+        void _setModule() {
+            _module = MODULE;
+            if (MODULE_WIZE == MODULE) _ci = CI_WIZE;
+        }
+
+        /**
+         * @brief               Return the physical memory address for the given slot
+         * @param slot          Memory slot
+         * @return              An address, 0xFF if not available for this module
+         * @protected
+         */
+        inline uint8_t _address(uint8_t slot) {
+            return MEM_ADDRESS[MODULE-1][slot];
+        }
+
+};
+
+#endif
@@ -58,33 +58,34 @@ bool AllWize_LoRaWAN::joinABP(uint8_t *DevAddr, uint8_t *AppSKey, uint8_t * NwkS
 }
 
 /**
- * @brief               Returns latest received message (rebuilds LoRaWan header if necessary)
- * @return              New message
+ * @brief               Rebuilds LoRaWAN MAC header and payload in place from
+ *                      Wize header info if C-Field matches LORAWAN_C_FIELD_MASK mask
+ * @param message       Message just decoded into the receive queue
+ * @protected
  */
-allwize_message_t AllWize_LoRaWAN::read() {
+void AllWize_LoRaWAN::_postDecode(allwize_message_t * message) {
     
-    allwize_message_t raw = AllWize::read();
-
-    // Rebuilds LoRaWAN MAC header and payload from
-    // Wize header info if C-Field matches LORAWAN_C_FIELD_MASK mask
-    if ((raw.c & LORAWAN_C_FIELD_MASK) == LORAWAN_C_FIELD_MASK) {
-        uint8_t tmp[RX_BUFFER_SIZE];
-        tmp[0] = (raw.c & 0x0F) << 4;
-        tmp[1] = raw.address[3];
-        tmp[2] = raw.address[2];
-        tmp[3] = raw.address[1];
-        tmp[4] = raw.address[0];
-        tmp[5] = LORAWAN_FRAME_CONTROL;
-        tmp[6] = raw.wize_counter & 0xFF;
-        tmp[7] = raw.wize_counter >> 8;
-        tmp[8] = raw.wize_application;
-        memcpy(&tmp[9], raw.data, raw.len);
-        raw.len += 9;
-        memcpy(raw.data, tmp, raw.len);
+    if ((message->c & LORAWAN_C_FIELD_MASK) == LORAWAN_C_FIELD_MASK) {
+        #if RX_DECODE_IN_PLACE
+            // The Wize header bytes before the payload in the raw frame have already been decoded
+            if (message->data - _buffer < 9) return;
+            message->data -= 9;
+        #else
+            if (message->len + 9 >= RX_BUFFER_SIZE) return;
+            memmove(&message->data[9], message->data, message->len + 1);
+        #endif
+        message->data[0] = (message->c & 0x0F) << 4;
+        message->data[1] = message->address[3];
+        message->data[2] = message->address[2];
+        message->data[3] = message->address[1];
+        message->data[4] = message->address[0];
+        message->data[5] = LORAWAN_FRAME_CONTROL;
+        message->data[6] = message->wize_counter & 0xFF;
+        message->data[7] = message->wize_counter >> 8;
+        message->data[8] = message->wize_application;
+        message->len += 9;
     }
 
-    return raw;
-
 }
 
 /**
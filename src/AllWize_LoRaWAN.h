@@ -73,7 +73,6 @@ class AllWize_LoRaWAN: public AllWize {
         #endif
         AllWize_LoRaWAN(uint8_t rx, uint8_t tx, uint8_t reset_gpio = GPIO_NONE, uint8_t config_gpio = GPIO_NONE): AllWize(rx, tx, reset_gpio, config_gpio) {}
 
-        allwize_message_t read();
         bool joinABP(uint8_t *DevAddr, uint8_t *AppSKey, uint8_t * NwkSKey);
         bool send(uint8_t *Data, uint8_t Data_Length, uint8_t Frame_Port = 0x01);
         uint16_t getFrameCounter();
@@ -86,6 +85,8 @@ class AllWize_LoRaWAN: public AllWize {
         uint8_t _nwkskey[16];
         static const uint8_t S_Table[16][16];
 
+        void _postDecode(allwize_message_t * message);
+
         void Encrypt_Payload(uint8_t *Data, uint8_t Data_Length, uint16_t Frame_Counter, uint8_t Direction);
         void Calculate_MIC(uint8_t *Data, uint8_t *Final_MIC, uint8_t Data_Length, uint16_t Frame_Counter, uint8_t Direction);
         void Generate_Keys(uint8_t *K1, uint8_t *K2);
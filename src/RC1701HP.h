@@ -272,3 +272,4 @@ static const uint32_t DATARATES[4] = {2400, 4800, 6400, 9600};
 #define BAUDRATE_230400                 0x0B
 
 static const uint32_t BAUDRATES[11] = {2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 76800, 115200, 230400};
+#define BAUDRATE_COUNT                  (sizeof(BAUDRATES) / sizeof(BAUDRATES[0]))
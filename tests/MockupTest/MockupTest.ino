@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "AllWize.h"
+#include "AllWizeT.h"
 #include "RC1701XX_Mockup.h"
 
 #include "AUnit.h"
@@ -38,13 +39,49 @@ using namespace aunit;
 // Test class
 // -----------------------------------------------------------------------------
 
+// AllWize instance with access to the internals the tests need, it does not touch
+// the serial port on reset and simulates a host that only reaches up to a given baud rate
+class AllWizeMock: public AllWize {
+    public:
+        AllWizeMock(RC1701XX_Mockup * mock) : AllWize((HardwareSerial *) mock), _mock(mock) {}
+        // Behaves as the given module type without querying it
+        void setModule(uint8_t module) {
+            _module = module;
+            _mock->setBaudRateAddress(_getAddress(MEM_UART_BAUD_RATE));
+        }
+        uint8_t getAddress(uint8_t slot) {
+            return _getAddress(slot);
+        }
+        void parseModel(const char * signature) {
+            _parseModel(signature);
+        }
+        void setMaxBaudRate(uint32_t max_baudrate) {
+            _max_baudrate = max_baudrate;
+        }
+        void setSerialBaudRate(uint32_t baudrate) {
+            _baudrate = baudrate;
+            _resetSerial();
+        }
+        uint32_t getSerialBaudRate() {
+            return _baudrate;
+        }
+    protected:
+        void _resetSerial() override {
+            _flush();
+            _mock->mute(_baudrate > _max_baudrate);
+            _mock->setHostBaudRate(_getBaudRateCode());
+        }
+        RC1701XX_Mockup * _mock;
+        uint32_t _max_baudrate = 0xFFFFFFFF;
+};
+
 class CustomTest: public TestOnce {
 
     protected:
 
         virtual void setup() override {
             mock = new RC1701XX_Mockup();
-            allwize = new AllWize((HardwareSerial *) mock);
+            allwize = new AllWizeMock(mock);
             mock->reset();
         }
 
@@ -60,8 +97,48 @@ class CustomTest: public TestOnce {
             }
         }
 
+        virtual void inject(size_t len, uint8_t * frame) {
+            for (uint8_t i=0; i<len; i++) {
+                mock->rx_write(frame[i]);
+            }
+        }
+
+        // Configures the frame format the tests inject
+        virtual void listen(uint8_t data_interface, bool append_rssi = false, bool continuous = false) {
+            allwize->setDataInterface(data_interface);
+            allwize->setAppendRSSI(append_rssi);
+            allwize->setContinuousRX(continuous);
+        }
+
+        // Injects the shortest DATA_INTERFACE_APP_ONLY frame, with a single data byte
+        virtual void injectShort(uint8_t value) {
+            uint8_t frame[] = {2, CI_APP_RESPONSE_UP_SHORT, value};
+            inject(sizeof(frame), frame);
+        }
+
         RC1701XX_Mockup * mock;
-        AllWize * allwize;
+        AllWizeMock * allwize;
+
+};
+
+// Tests for the AllWizeT front end, no AllWize instance is created
+class TemplateTest: public CustomTest {
+
+    protected:
+
+        virtual void setup() override {
+            mock = new RC1701XX_Mockup();
+            allwize = NULL;
+            wize = new AllWizeT<MODULE_WIZE>((HardwareSerial *) mock);
+            mock->reset();
+        }
+
+        virtual void teardown() override {
+            delete wize;
+            delete mock;
+        }
+
+        AllWizeT<MODULE_WIZE> * wize;
 
 };
 
@@ -69,14 +146,85 @@ class CustomTest: public TestOnce {
 // Tests
 // -----------------------------------------------------------------------------
 
-// Not working and I don't know yet how to test it
-/*
+void count_messages(const allwize_view_t & message, void * ctx) {
+    *((uint16_t *) ctx) += message.data[0];
+}
+
+void command_done(int8_t result, const uint8_t * response, void * ctx) {
+    *((int16_t *) ctx) = (result > 0) ? response[0] : result;
+}
+
 testF(CustomTest, reset) {
-    allwize->reset();
-    uint8_t expected[] = {0x00, 'M', 0x37, 1, 0xFF, 0x58, 0x00, '@', 'R', 'R'};
-    compare(sizeof(expected), expected);
+    allwize->setModule(MODULE_WIZE);
+    assertTrue(allwize->reset());
+    assertMoreOrEqual(allwize->getResetTime(), (uint32_t) RESET_GUARD_TIME);
+    assertLess(allwize->getResetTime(), (uint32_t) RESET_TIMEOUT);
+    uint8_t previous = 0;
+    bool found = false;
+    while (mock->rx_available()) {
+        uint8_t ch = mock->rx_read();
+        if (('@' == previous) && ('R' == ch)) found = ('R' == mock->rx_read());
+        previous = ch;
+    }
+    assertTrue(found);
+}
+
+testF(CustomTest, reset_not_ready) {
+    allwize->setModule(MODULE_WIZE);
+    allwize->setMaxBaudRate(0);
+    assertFalse(allwize->reset());
 }
-*/
+
+testF(CustomTest, wait_for_ready_timeout) {
+    allwize->setModule(MODULE_WIZE);
+    mock->mute(true);
+    uint32_t start = millis();
+    assertFalse(allwize->waitForReady(50));
+    assertLess(millis() - start, (uint32_t) (50 + 2 * RESET_PROBE_TIMEOUT + RESET_PROBE_INTERVAL));
+}
+
+testF(CustomTest, negotiate_baud_rate) {
+    allwize->setModule(MODULE_WIZE);
+    uint32_t start = millis();
+    assertEqual(BAUDRATE_57600, allwize->negotiateBaudRate(BAUDRATE_57600));
+    assertEqual((uint32_t) 57600, allwize->getSerialBaudRate());
+    assertLess(millis() - start, (uint32_t) BAUDRATE_PROBE_TIMEOUT);
+}
+
+testF(CustomTest, negotiate_baud_rate_fallback) {
+    // Module boots at the default baud rate if the saved one is not supported
+    allwize->setModule(MODULE_WIZE);
+    mock->setMaxBaudRate(BAUDRATE_57600);
+    assertEqual(BAUDRATE_57600, allwize->negotiateBaudRate(BAUDRATE_76800));
+    assertEqual((uint32_t) 57600, allwize->getSerialBaudRate());
+    assertEqual(BAUDRATE_57600, mock->getSavedBaudRate());
+    allwize_fingerprint_t fingerprint;
+    assertTrue(allwize->getFingerprint(fingerprint));
+    assertEqual(BAUDRATE_57600, fingerprint.baudrate);
+}
+
+testF(CustomTest, negotiate_baud_rate_restore) {
+    // Module already at 57600 falls back to 19200, 57600 has to be saved back
+    allwize->setModule(MODULE_WIZE);
+    mock->setBaudRate(BAUDRATE_57600);
+    mock->setMaxBaudRate(BAUDRATE_57600);
+    allwize->setSerialBaudRate(57600);
+    assertEqual(BAUDRATE_57600, allwize->negotiateBaudRate(BAUDRATE_76800));
+    assertEqual((uint32_t) 57600, allwize->getSerialBaudRate());
+    assertEqual(BAUDRATE_57600, mock->getBaudRate());
+    assertEqual(BAUDRATE_57600, mock->getSavedBaudRate());
+}
+
+#if MODEM_UPGRADE_BAUDRATE > BAUDRATE_57600
+testF(CustomTest, begin_negotiated_baud_rate) {
+    // A previous begin settled on a baud rate below MODEM_UPGRADE_BAUDRATE
+    mock->setBaudRate(BAUDRATE_57600);
+    allwize->begin();
+    assertEqual((uint32_t) 57600, allwize->getSerialBaudRate());
+    assertLess(allwize->getResetTime(), (uint32_t) RESET_TIMEOUT);
+    assertTrue(allwize->ready());
+}
+#endif
 
 testF(CustomTest, set_channel) {
     uint8_t channel = 3;
@@ -92,6 +240,201 @@ testF(CustomTest, set_channel_persist) {
     compare(sizeof(expected), expected);
 }
 
+testF(CustomTest, config_transaction) {
+    uint8_t channel = 3;
+    uint8_t value = C_SND_NR;
+    assertTrue(allwize->beginConfig());
+    allwize->setChannel(channel);
+    allwize->setControlField(value);
+    assertTrue(allwize->commitConfig());
+    uint8_t expected[] = {0x00, 'C', channel, 'F', value, 0x58};
+    compare(sizeof(expected), expected);
+    assertFalse(allwize->commitConfig());
+}
+
+#if USE_MEMORY_CACHE == MEMORY_CACHE_FULL
+testF(CustomTest, config_transaction_memory) {
+    allwize->setModule(MODULE_WIZE);
+    uint8_t channel = 3;
+    assertTrue(allwize->beginConfig());
+    allwize->setChannel(channel, true);
+    assertTrue(allwize->commitConfig());
+    uint8_t expected[] = {0x00, 'C', channel, 'M', 0x00, channel, 0x01, channel, 0xFF, 0x58};
+    compare(sizeof(expected), expected);
+}
+
+testF(CustomTest, memory_cache_page) {
+    allwize->setModule(MODULE_WIZE);
+    assertEqual(MOCKUP_RESPONSE_BYTE, allwize->getChannel());
+    assertEqual(MEMORY_PAGE_SIZE * 2 + 2, mock->rx_available());
+    mock->rx_flush();
+    assertEqual(MOCKUP_RESPONSE_BYTE, allwize->getChannel());
+    assertEqual(0, mock->rx_available());
+}
+#elif USE_MEMORY_CACHE == MEMORY_CACHE_SLOTS
+testF(CustomTest, memory_cache_slots) {
+    allwize->setModule(MODULE_WIZE);
+    assertEqual(MOCKUP_RESPONSE_BYTE, allwize->getChannel());
+    mock->rx_flush();
+    assertEqual(MOCKUP_RESPONSE_BYTE, allwize->getChannel());
+    assertEqual(0, mock->rx_available());
+    allwize->setChannel(3, true);
+    mock->rx_flush();
+    assertEqual(3, allwize->getChannel());
+    assertEqual(0, mock->rx_available());
+}
+
+testF(TemplateTest, memory_cache_slots_template) {
+    assertEqual(MOCKUP_RESPONSE_BYTE, wize->getChannel());
+    wize->setChannel(3, true);
+    wize->setDataRate(DATARATE_2400bps);
+    mock->rx_flush();
+    assertEqual(3, wize->getChannel());
+    assertEqual(DATARATE_2400bps, wize->getDataRate());
+    assertEqual(0, mock->rx_available());
+}
+#endif
+
+testF(CustomTest, command_async) {
+    int16_t result = -2;
+    assertTrue(allwize->commandAsync(CMD_RSSI, NULL, 0, command_done, &result));
+    assertFalse(allwize->commandAsync(CMD_RSSI));
+    while (allwize->poll());
+    assertEqual(MOCKUP_RESPONSE_BYTE, result);
+    uint8_t expected[] = {0x00, CMD_RSSI, 0x58};
+    compare(sizeof(expected), expected);
+}
+
+testF(CustomTest, command_async_partial_frame) {
+    listen(DATA_INTERFACE_APP_ONLY);
+    uint8_t frame[] = {4, CI_APP_RESPONSE_UP_SHORT, 'A', 'B', 'C'};
+    inject(3, frame);
+    assertEqual(0, (int) allwize->pump());
+    int16_t result = -2;
+    assertTrue(allwize->commandAsync(CMD_RSSI, NULL, 0, command_done, &result));
+    while (allwize->poll());
+    assertEqual(MOCKUP_RESPONSE_BYTE, result);
+    mock->rx_flush();
+    inject(2, &frame[3]);
+    assertTrue(allwize->available());
+    allwize_message_t message = allwize->read();
+    assertEqual(3, (int) message.len);
+    assertEqual('A', message.data[0]);
+    assertEqual('C', message.data[2]);
+}
+
+testF(CustomTest, read_rate) {
+    allwize->setModule(MODULE_WIZE);
+    assertEqual(0, (int) allwize->getReadRate());
+    allwize->getChannel();
+    assertMore(allwize->getReadRate(), (uint32_t) 0);
+}
+
+testF(CustomTest, apply_profile) {
+    allwize->setModule(MODULE_WIZE);
+    allwize_profile_t profile = {
+        MOCKUP_RESPONSE_BYTE, PROFILE_KEEP, PROFILE_KEEP, PROFILE_KEEP,
+        PROFILE_KEEP, PROFILE_KEEP, PROFILE_KEEP, NULL
+    };
+    assertEqual(0, allwize->applyProfile(profile));
+    while (mock->rx_available()) assertNotEqual('M', mock->rx_read());
+    profile.network_role = NETWORK_ROLE_MASTER;
+    profile.channel = 3;
+    profile.data_interface = DATA_INTERFACE_APP_ONLY;
+    assertEqual(PROFILE_NETWORK_ROLE | PROFILE_CHANNEL | PROFILE_DATA_INTERFACE, allwize->applyProfile(profile));
+    #if USE_MEMORY_CACHE == MEMORY_CACHE_FULL
+        // Writes are staged and saved in a single session
+        uint8_t sessions = 0;
+        while (mock->rx_available()) {
+            if ('M' == mock->rx_read()) sessions++;
+        }
+        assertEqual(1, sessions);
+    #endif
+    assertEqual(NETWORK_ROLE_MASTER, allwize->getNetworkRole());
+}
+
+testF(CustomTest, apply_profile_values) {
+    allwize->setModule(MODULE_OSP);
+    mock->setMemory(allwize->getAddress(MEM_DATA_RATE), DATARATE_6400bps_OSP);
+    allwize_profile_t profile = {
+        PROFILE_KEEP, PROFILE_KEEP, PROFILE_KEEP, DATARATE_6400bps,
+        PROFILE_KEEP, PROFILE_KEEP, PROFILE_KEEP, NULL
+    };
+    assertEqual(0, allwize->applyProfile(profile));
+    allwize->setModule(MODULE_WIZE);
+    profile.data_rate = PROFILE_KEEP;
+    profile.mbus_mode = MBUS_MODE_OSP;
+    assertEqual(PROFILE_ERROR, allwize->applyProfile(profile));
+}
+
+testF(TemplateTest, module_template) {
+    assertEqual(MODULE_WIZE, wize->getModuleType());
+    assertEqual(CI_WIZE, wize->getControlInformation());
+    wize->setMode(MBUS_MODE_OSP);
+    assertEqual(0, mock->rx_available());
+    wize->setMode(MBUS_MODE_N1);
+    uint8_t expected[] = {0x00, 'G', MBUS_MODE_N1, 0x58};
+    compare(sizeof(expected), expected);
+}
+
+testF(TemplateTest, begin_fingerprint_template) {
+    allwize_fingerprint_t fingerprint;
+    assertTrue(wize->getFingerprint(fingerprint));
+    fingerprint.checksum++;
+    assertFalse(wize->begin(fingerprint));
+    assertEqual(MODULE_WIZE, ((AllWize *) wize)->getModuleType());
+}
+
+testF(CustomTest, get_fingerprint) {
+    allwize_fingerprint_t fingerprint;
+    assertFalse(allwize->getFingerprint(fingerprint));
+    allwize->setModule(MODULE_WIZE);
+    assertTrue(allwize->getFingerprint(fingerprint));
+    assertEqual(MODULE_WIZE, fingerprint.module);
+    assertEqual(0, mock->rx_available());
+}
+
+testF(CustomTest, begin_fingerprint) {
+    allwize->setModule(MODULE_WIZE);
+    allwize_fingerprint_t fingerprint;
+    assertTrue(allwize->getFingerprint(fingerprint));
+    uint8_t mbus_mode = allwize->getAddress(MEM_MBUS_MODE);
+    uint8_t rssi_mode = allwize->getAddress(MEM_RSSI_MODE);
+    uint8_t data_interface = allwize->getAddress(MEM_DATA_INTERFACE);
+    uint8_t baudrate = allwize->getAddress(MEM_UART_BAUD_RATE);
+    mock->setMemory(mbus_mode, fingerprint.mbus_mode);
+    mock->setMemory(rssi_mode, fingerprint.append_rssi);
+    mock->setMemory(data_interface, fingerprint.data_interface);
+    mock->setMemory(baudrate, fingerprint.baudrate);
+    assertTrue(allwize->begin(fingerprint));
+    uint8_t expected[] = {0x00, 'Y', mbus_mode, 'Y', rssi_mode, 'Y', data_interface, 'Y', baudrate, 0x58};
+    compare(sizeof(expected), expected);
+    // RSSI mode changed behind the library back
+    mock->setMemory(rssi_mode, 1 - fingerprint.append_rssi);
+    assertFalse(allwize->begin(fingerprint));
+}
+
+testF(CustomTest, get_uid_buffer) {
+    allwize->setModule(MODULE_WIZE);
+    char uid[9];
+    assertFalse(allwize->getUID(uid, sizeof(uid) - 1));
+    assertEqual((size_t) 0, strlen(uid));
+    assertTrue(allwize->getUID(uid, sizeof(uid)));
+    assertEqual("A0A0A0A0", uid);
+}
+
+testF(CustomTest, parse_model) {
+    allwize->parseModel(" RC1701HP-WIZE,0100, 0203  ");
+    char buffer[17];
+    assertTrue(allwize->getPartNumber(buffer, sizeof(buffer)));
+    assertEqual("RC1701HP-WIZE", buffer);
+    assertTrue(allwize->getRequiredHardwareVersion(buffer, sizeof(buffer)));
+    assertEqual("0100", buffer);
+    assertTrue(allwize->getFirmwareVersion(buffer, sizeof(buffer)));
+    assertEqual("0203", buffer);
+    assertEqual(0, mock->rx_available());
+}
+
 testF(CustomTest, get_channel) {
     allwize->getChannel();
     uint8_t expected[] = {0x00, 'Y', 0x00, 0x58};
@@ -208,6 +551,295 @@ testF(CustomTest, get_serial_number) {
     compare(sizeof(expected), expected);
 }
 
+testF(CustomTest, receive_without_silence_gap) {
+    listen(DATA_INTERFACE_START_STOP);
+    uint8_t frame[] = {
+        START_BYTE, 13,
+        C_SND_NR, 0x2D, 0x2C, 0x04, 0x03, 0x02, 0x01, 0x01, 0x00,
+        CI_APP_RESPONSE_UP_SHORT, 'A', 'B', 'C',
+        STOP_BYTE
+    };
+    inject(sizeof(frame), frame);
+    assertTrue(allwize->available());
+    allwize_message_t message = allwize->read();
+    assertEqual(3, (int) message.len);
+    assertEqual('A', (char) message.data[0]);
+    assertEqual(0x01, (int) message.address[0]);
+    assertEqual(0x04, (int) message.address[3]);
+    assertTrue(message.last_byte_us - message.first_byte_us < 1000000UL);
+}
+
+testF(CustomTest, receive_queue_drop_oldest) {
+    listen(DATA_INTERFACE_START_STOP);
+    uint8_t frame[] = {
+        START_BYTE, 11,
+        C_SND_NR, 0x2D, 0x2C, 0x04, 0x03, 0x02, 0x01, 0x01, 0x00,
+        CI_APP_RESPONSE_UP_SHORT, 0x00,
+        STOP_BYTE
+    };
+    for (uint8_t i=0; i<=RX_QUEUE_SIZE; i++) {
+        frame[12] = i;
+        inject(sizeof(frame), frame);
+        assertTrue(allwize->available());
+    }
+    assertEqual(RX_QUEUE_SIZE, (int) allwize->getQueueCount());
+    assertEqual(1, (int) allwize->getQueueOverflows());
+    for (uint8_t i=1; i<=RX_QUEUE_SIZE; i++) {
+        assertEqual(i, allwize->read().data[0]);
+    }
+    assertFalse(allwize->available());
+}
+
+testF(CustomTest, receive_soft_reset) {
+    listen(DATA_INTERFACE_APP_ONLY);
+    injectShort(0x00);
+    assertTrue(allwize->available());
+    uint8_t expected[] = {0x00, 0x58};
+    compare(sizeof(expected), expected);
+}
+
+testF(CustomTest, pump_soft_reset) {
+    listen(DATA_INTERFACE_APP_ONLY);
+    uint16_t total = 0;
+    allwize->onMessage(count_messages, &total);
+    uint8_t expected[] = {0x00, 0x58};
+    for (uint8_t i=1; i<=2; i++) {
+        injectShort(i);
+        assertEqual(1, (int) allwize->pump());
+        compare(sizeof(expected), expected);
+    }
+    assertEqual(3, (int) total);
+    assertEqual(0, (int) allwize->getQueueCount());
+}
+
+testF(CustomTest, receive_continuous) {
+    listen(DATA_INTERFACE_APP_ONLY, false, true);
+    injectShort(0x00);
+    injectShort(0x00);
+    assertTrue(allwize->available());
+    assertEqual((RX_QUEUE_SIZE > 1) ? 2 : 1, (int) allwize->getQueueCount());
+    assertEqual(0, mock->rx_available());
+}
+
+testF(CustomTest, receive_oversized) {
+    listen(DATA_INTERFACE_APP_ONLY, false, true);
+    // Frame too long for the RX buffer whose payload looks like a chain of frames
+    uint8_t length = 0xFF;
+    uint8_t bogus[] = {2, CI_APP_RESPONSE_UP_SHORT, 0xAA};
+    inject(1, &length);
+    for (uint8_t i=0; i<85; i++) {
+        inject(sizeof(bogus), bogus);
+        if (0 == i % 16) allwize->available();
+    }
+    injectShort(0x01);
+    assertTrue(allwize->available());
+    assertEqual(1, (int) allwize->getQueueCount());
+    assertEqual(0x01, (int) allwize->read().data[0]);
+    assertEqual(1, (int) allwize->getOversizedFrames());
+}
+
+#if RX_LATENCY_BUCKETS > 6
+testF(CustomTest, receive_latency_histogram) {
+    listen(DATA_INTERFACE_APP_ONLY);
+    allwize->resetLatencyHistogram();
+    // Read 40ms after the first byte, bucket 6 counts from 32 to 64ms
+    injectShort(0x00);
+    assertTrue(allwize->available());
+    delay(40);
+    allwize->read();
+    assertEqual(1, (int) allwize->getLatencyHistogram(6));
+    // Latencies above the last bucket are counted in it
+    injectShort(0x00);
+    assertTrue(allwize->available());
+    delay(1UL << (RX_LATENCY_BUCKETS - 1));
+    allwize->read();
+    assertEqual(1, (int) allwize->getLatencyHistogram(RX_LATENCY_BUCKETS - 1));
+    assertEqual(0, (int) allwize->getLatencyHistogram(RX_LATENCY_BUCKETS));
+    allwize->resetLatencyHistogram();
+    assertEqual(0, (int) allwize->getLatencyHistogram(6));
+}
+#endif
+
+testF(CustomTest, receive_view) {
+    listen(DATA_INTERFACE_APP_ONLY, true);
+    uint8_t frame[] = {5, CI_APP_RESPONSE_UP_SHORT, 'A', 'B', 'C', 0x80};
+    inject(sizeof(frame), frame);
+    allwize_view_t view;
+    assertTrue(allwize->available());
+    assertTrue(allwize->read(view));
+    assertEqual(3, (int) view.len);
+    assertEqual('C', (char) view.data[2]);
+    assertEqual(0x80, (int) view.rssi);
+    assertFalse(allwize->read(view));
+}
+
+#if RX_DECODE_IN_PLACE
+testF(CustomTest, receive_in_place) {
+    listen(DATA_INTERFACE_APP_ONLY, true, true);
+    uint8_t frame[] = {5, CI_APP_RESPONSE_UP_SHORT, 'A', 'B', 'C', 0x80};
+    inject(sizeof(frame), frame);
+    inject(sizeof(frame), frame);
+    assertTrue(allwize->available());
+    assertEqual(sizeof(frame), (size_t) mock->available());
+    allwize_message_t message = allwize->read();
+    assertTrue(message.data == &allwize->getBuffer()[2]);
+    assertEqual("ABC", (char *) message.data);
+    assertEqual(0x80, (int) message.rssi);
+}
+#endif
+
+#if not RX_DECODE_IN_PLACE
+testF(CustomTest, message_copy) {
+    allwize_message_t message;
+    message.len = 3;
+    message.rssi = 0x80;
+    memcpy(message.data, "ABCD", 5);
+    allwize_message_t copy = message;
+    assertEqual(3, (int) copy.len);
+    assertEqual(0x80, (int) copy.rssi);
+    assertEqual("ABC", (char *) copy.data);
+}
+#endif
+
+#if not RX_DECODE_IN_PLACE
+testF(CustomTest, read_many_soft_reset) {
+    listen(DATA_INTERFACE_APP_ONLY);
+    for (uint8_t i=1; i<=3; i++) {
+        injectShort(i);
+    }
+    allwize_message_t messages[4];
+    assertEqual(3, (int) allwize->readMany(messages, 4));
+    for (uint8_t i=0; i<3; i++) {
+        assertEqual(i + 1, messages[i].data[0]);
+    }
+    uint8_t expected[] = {0x00, 0x58};
+    compare(sizeof(expected), expected);
+}
+#endif
+
+testF(CustomTest, read_many) {
+    listen(DATA_INTERFACE_ID_ADDR, false, true);
+    uint8_t frame[] = {
+        11,
+        C_SND_NR, 0x2D, 0x2C, 0x04, 0x03, 0x02, 0x01, 0x01, 0x00,
+        CI_APP_RESPONSE_UP_SHORT, 0x00
+    };
+    for (uint8_t i=0; i<3; i++) {
+        frame[11] = i;
+        inject(sizeof(frame), frame);
+    }
+    allwize_message_t messages[4];
+    assertEqual(3, (int) allwize->readMany(messages, 4));
+    for (uint8_t i=0; i<3; i++) {
+        assertEqual(i, messages[i].data[0]);
+    }
+    assertEqual(0, (int) allwize->getQueueOverflows());
+}
+
+testF(CustomTest, on_message) {
+    listen(DATA_INTERFACE_APP_ONLY, false, true);
+    uint16_t total = 0;
+    allwize->onMessage(count_messages, &total);
+    for (uint8_t i=1; i<=3; i++) {
+        injectShort(i);
+    }
+    assertEqual(3, (int) allwize->pump());
+    assertEqual(6, (int) total);
+    assertEqual(0, (int) allwize->getQueueCount());
+}
+
+testF(CustomTest, receive_crc) {
+    listen(DATA_INTERFACE_CRC_START_STOP);
+    uint8_t frame[] = {
+        START_BYTE, 15,
+        C_SND_NR, 0x2D, 0x2C, 0x04, 0x03, 0x02, 0x01, 0x01, 0x00,
+        CI_APP_RESPONSE_UP_SHORT, 'A', 'B', 'C',
+        0xCD, 0xE2,
+        STOP_BYTE
+    };
+    inject(sizeof(frame), frame);
+    assertTrue(allwize->available());
+    allwize_message_t message = allwize->read();
+    assertTrue(message.crc_ok);
+    assertEqual(3, (int) message.len);
+    frame[13] = 'X';
+    inject(sizeof(frame), frame);
+    assertFalse(allwize->available());
+    assertEqual(1, (int) allwize->getCRCErrors());
+}
+
+testF(CustomTest, receive_filter) {
+    listen(DATA_INTERFACE_ID_ADDR, false, true);
+    const uint32_t addresses[] = { 0x01020304, 0x01020306, 0x0A000000 };
+    allwize->setFilter(addresses, 3);
+    uint8_t frame[] = {
+        12,
+        C_SND_NR, 0x2D, 0x2C, 0x04, 0x03, 0x02, 0x01, 0x01, 0x00,
+        CI_APP_RESPONSE_UP_SHORT, 'A', 'B'
+    };
+    inject(sizeof(frame), frame);
+    frame[4] = 0x05;
+    inject(sizeof(frame), frame);
+    frame[4] = 0x06;
+    inject(sizeof(frame), frame);
+    assertEqual(2, (int) allwize->pump());
+    assertEqual(2, (int) allwize->getFilterHits());
+    assertEqual(1, (int) allwize->getFilterMisses());
+    allwize_message_t message = allwize->read();
+    assertEqual(0x04, (int) message.address[3]);
+    message = allwize->read();
+    assertEqual(0x06, (int) message.address[3]);
+}
+
+#if (DEDUP_CACHE_SIZE > 0) && DEDUP_DROP
+testF(CustomTest, receive_duplicate) {
+    allwize->setModule(MODULE_WIZE);
+    listen(DATA_INTERFACE_ID_ADDR, false, true);
+    uint8_t frame[] = {
+        16,
+        C_SND_NR, 0x2D, 0x2C, 0x04, 0x03, 0x02, 0x01, 0x01, 0x00,
+        CI_WIZE, 0x40, 0x01, 0x05, 0x00, 0xFE,
+        'A'
+    };
+    inject(sizeof(frame), frame);
+    inject(sizeof(frame), frame);
+    frame[13] = 0x06;
+    inject(sizeof(frame), frame);
+    assertTrue(allwize->available());
+    assertEqual(2, (int) allwize->getQueueCount());
+    assertEqual(1, (int) allwize->getDuplicates());
+    allwize_message_t message = allwize->read();
+    assertEqual(5, (int) message.wize_counter);
+    assertFalse(message.duplicate);
+    message = allwize->read();
+    assertEqual(6, (int) message.wize_counter);
+}
+
+testF(CustomTest, receive_duplicate_dropped) {
+    allwize->setModule(MODULE_WIZE);
+    listen(DATA_INTERFACE_ID_ADDR, false, true);
+    allwize->setQueuePolicy(RX_QUEUE_DROP_NEWEST);
+    uint8_t frame[] = {
+        16,
+        C_SND_NR, 0x2D, 0x2C, 0x04, 0x03, 0x02, 0x01, 0x01, 0x00,
+        CI_WIZE, 0x40, 0x01, 0x00, 0x00, 0xFE,
+        'A'
+    };
+    for (uint8_t i=0; i<=RX_QUEUE_SIZE; i++) {
+        frame[13] = i;
+        inject(sizeof(frame), frame);
+        allwize->available();
+    }
+    assertEqual(1, (int) allwize->getQueueOverflows());
+    while (allwize->getQueueCount() > 0) allwize->read();
+    // The repeated copy of the dropped message is not a duplicate
+    inject(sizeof(frame), frame);
+    assertTrue(allwize->available());
+    assertEqual(0, (int) allwize->getDuplicates());
+    assertEqual(RX_QUEUE_SIZE, (int) allwize->read().wize_counter);
+}
+#endif
+
 // -----------------------------------------------------------------------------
 // Main
 // -----------------------------------------------------------------------------
@@ -27,6 +27,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MOCKUP_RESPONSE_BYTE        0xA0
 #define MOCKUP_DEBUG                0
 #define MOCKUP_BUFFER_SIZE          128
+#define MOCKUP_BAUDRATE             0x05    // 19200
+#define MOCKUP_MEMORY_SIZE          8       // Memory positions the mockup remembers
 
 class CircularBuffer {
 
@@ -99,6 +101,12 @@ class RC1701XX_Mockup : public Stream {
             _config_mode = false;
             _memory_mode = false;
             _command_mode = false;
+            _muted = false;
+            _baud_address = 0xFF;
+            _baudrate = _saved_baudrate = MOCKUP_BAUDRATE;
+            _max_baudrate = 0xFF;
+            _host_baudrate = 0;
+            _memory_count = 0;
             _rx->flush();
             _tx->flush();
         }
@@ -114,6 +122,8 @@ class RC1701XX_Mockup : public Stream {
                 SerialUSB.println((uint8_t) ch, HEX);
             #endif
 
+            if (_muted) return 1;
+            if ((0 != _host_baudrate) && (_host_baudrate != _baudrate)) return 1;
             _process(ch);
             return _rx->write(ch);
 
@@ -162,6 +172,67 @@ class RC1701XX_Mockup : public Stream {
             _rx->flush();
         }
 
+        // Ignores everything sent to the module, as if the line speeds did not match
+        virtual void mute(bool muted) {
+            _muted = muted;
+        }
+
+        // ---------------------------------------------------------------------
+        // UART speed, the module saves the baud rate (code) written to the given
+        // memory address and switches to it when it reboots, falling back to the
+        // default one if it is above the max it supports. It only hears the host
+        // when both run at the same baud rate, 0 for the host disables the check.
+        // ---------------------------------------------------------------------
+
+        virtual void setBaudRateAddress(uint8_t address) {
+            _baud_address = address;
+        }
+
+        virtual void setBaudRate(uint8_t baudrate) {
+            _baudrate = _saved_baudrate = baudrate;
+        }
+
+        virtual void setMaxBaudRate(uint8_t baudrate) {
+            _max_baudrate = baudrate;
+        }
+
+        virtual void setHostBaudRate(uint8_t baudrate) {
+            _host_baudrate = baudrate;
+        }
+
+        virtual uint8_t getBaudRate() {
+            return _baudrate;
+        }
+
+        virtual uint8_t getSavedBaudRate() {
+            return _saved_baudrate;
+        }
+
+        // ---------------------------------------------------------------------
+        // Memory, read commands return MOCKUP_RESPONSE_BYTE unless the position
+        // has been set or written (only MOCKUP_MEMORY_SIZE positions are kept)
+        // ---------------------------------------------------------------------
+
+        virtual void setMemory(uint8_t address, uint8_t value) {
+            for (uint8_t i=0; i<_memory_count; i++) {
+                if (_memory_addresses[i] == address) {
+                    _memory_values[i] = value;
+                    return;
+                }
+            }
+            if (_memory_count < MOCKUP_MEMORY_SIZE) {
+                _memory_addresses[_memory_count] = address;
+                _memory_values[_memory_count++] = value;
+            }
+        }
+
+        virtual uint8_t getMemory(uint8_t address) {
+            for (uint8_t i=0; i<_memory_count; i++) {
+                if (_memory_addresses[i] == address) return _memory_values[i];
+            }
+            return MOCKUP_RESPONSE_BYTE;
+        }
+
     private:
 
         // ---------------------------------------------------------------------
@@ -186,11 +257,13 @@ class RC1701XX_Mockup : public Stream {
                         rx_write('>');
                     } else {
                         _pending_payload = 1;
+                        _memory(ch);
                     }
                     return;
                 }
 
                 // Handle cases
+                _command = ch;
                 switch (ch) {
 
                     case 0x00:
@@ -199,6 +272,7 @@ class RC1701XX_Mockup : public Stream {
 
                     case '@':
                         _command_mode = true;
+                        _pending_payload = 2;
                         return;
 
                     case 'A':
@@ -220,6 +294,7 @@ class RC1701XX_Mockup : public Stream {
 
                     case 'M':
                         _memory_mode = true;
+                        _memory_value = false;
                         _pending_payload = 2;
                         break;
 
@@ -263,15 +338,29 @@ class RC1701XX_Mockup : public Stream {
                 // Update pending payload
                 --_pending_payload;
 
+                // Module reboots after the @R* commands, @RC also restores the default baud rate
+                if (_command_mode) {
+                    if (0 == _pending_payload) {
+                        _command_mode = false;
+                        _config_mode = false;
+                        if ('C' == ch) _saved_baudrate = MOCKUP_BAUDRATE;
+                        _baudrate = (_saved_baudrate <= _max_baudrate) ? _saved_baudrate : MOCKUP_BAUDRATE;
+                    }
+                    return;
+                }
+
                 // Memory mode
-                if (_memory_mode || _command_mode) return;
+                if (_memory_mode) {
+                    _memory(ch);
+                    return;
+                }
 
                 // If no more payload
                 if (0 == _pending_payload) {
 
-                    // Inject response
+                    // Inject response, memory reads answer the value at the address just received
                     for (uint8_t i=0; i<_pending_response; i++) {
-                        rx_write(MOCKUP_RESPONSE_BYTE);
+                        rx_write(('Y' == _command) ? getMemory(ch) : MOCKUP_RESPONSE_BYTE);
                     }
 
                     // Reset response size
@@ -285,6 +374,17 @@ class RC1701XX_Mockup : public Stream {
             }
         }
 
+        // Address and value pairs written in memory mode
+        void _memory(uint8_t ch) {
+            if (!_memory_value) {
+                _memory_address = ch;
+            } else {
+                if (_memory_address == _baud_address) _saved_baudrate = ch;
+                setMemory(_memory_address, ch);
+            }
+            _memory_value = !_memory_value;
+        }
+
         CircularBuffer * _rx;  // Chars sent to the module (using write)
         CircularBuffer * _tx;  // Chars sent by the module (read-able)
 
@@ -293,5 +393,17 @@ class RC1701XX_Mockup : public Stream {
         bool _config_mode = false;
         bool _memory_mode = false;
         bool _command_mode = false;
+        bool _muted = false;
+        bool _memory_value = false;
+        uint8_t _memory_address = 0;
+        uint8_t _baud_address = 0xFF;
+        uint8_t _baudrate = MOCKUP_BAUDRATE;
+        uint8_t _saved_baudrate = MOCKUP_BAUDRATE;
+        uint8_t _max_baudrate = 0xFF;
+        uint8_t _host_baudrate = 0;
+        uint8_t _command = 0;
+        uint8_t _memory_count = 0;
+        uint8_t _memory_addresses[MOCKUP_MEMORY_SIZE];
+        uint8_t _memory_values[MOCKUP_MEMORY_SIZE];
 
 };